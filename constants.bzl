@@ -5,16 +5,26 @@ load("//:config.bzl", "MARCH_FLAG")
 
 # Compiler options
 
-# Slow, but full-precision random number generation.
+# UD rounding now always draws its sign bits from a per-thread bit pool, so
+# the two options below behave the same; they are kept for existing builds.
 RANDOM_FULLBITS_COPTS = [
     "-DPRISM_RANDOM_FULLBITS",
 ]
 
-# Fast, but partial-precision random number generation.
 RANDOM_PARTIALBITS_COPTS = [
     "-UPRISM_RANDOM_FULLBITS",
 ]
 
+# Counter-based Philox4x32-10 engine instead of xoshiro256++.
+RNG_PHILOX_COPTS = [
+    "-DPRISM_RNG_PHILOX",
+]
+
+# Counter-based AES-round (ARS-7) engine instead of xoshiro256++.
+RNG_AES_COPTS = [
+    "-DPRISM_RNG_AES",
+]
+
 COPTS = [
     "-std=c++17",
     "-Wfatal-errors",
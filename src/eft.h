@@ -33,4 +33,32 @@ template <typename T> inline void twoprodfma(T a, T b, T &sigma, T &tau) {
   debug_print("twoprodfma(%.13a, %.13a) = %.13a, %.13a\n", a, b, sigma, tau);
 }
 
+/*
+"Exact and Approximated error of the FMA"
+Sylvie Boldo, Jean-Michel Muller
+---
+Algorithm 5 (ErrFmaNearest):
+  r1 = ◦(ax + y)
+  (u1, u2) = Fast2Mult(a, x)
+  (α1, α2) = 2Sum(y, u2)
+  (β1, β2) = 2Sum(u1, α1)
+  γ = ◦(◦(β1 − r1) + β2)
+  r2 = ◦(γ + α2)
+*/
+template <typename T> inline void errfma(T a, T b, T c, T &r1, T &r2) {
+  T u1;
+  T u2;
+  T alpha1;
+  T alpha2;
+  T beta1;
+  T beta2;
+  r1 = std::fma(a, b, c);
+  twoprodfma(a, b, u1, u2);
+  twosum(c, u2, alpha1, alpha2);
+  twosum(u1, alpha1, beta1, beta2);
+  const T gamma = (beta1 - r1) + beta2;
+  r2 = gamma + alpha2;
+  debug_print("errfma(%.13a, %.13a, %.13a) = %.13a, %.13a\n", a, b, c, r1, r2);
+}
+
 #endif // __PRSIM_EFT_H__
\ No newline at end of file
@@ -18,6 +18,7 @@ auto fma = [](auto d, auto a, auto b, auto c) { return a; };
 #endif
 
 #include <type_traits>
+#include <utility>
 #include <cmath>
 
 #ifndef PRISM_PR_MODE_NAMESPACE
@@ -37,10 +38,441 @@ namespace variable::HWY_NAMESPACE {
 namespace hn = hwy::HWY_NAMESPACE;
 namespace pr = PRISM_PR_MODE_NAMESPACE::PRISM_DISPATCH::HWY_NAMESPACE;
 
+#if PRISM_PR_MODE == PRISM_SR_MODE
+/* Kernels with caller-supplied randomness: z holds one SR sample per element,
+ * either a Uniform[0, 1) value of the operand type or random bits of the same
+ * width, of which the top mantissa-width bits are used. */
+template <class D, typename Z>
+HWY_INLINE auto _load_z(const D d, const Z *HWY_RESTRICT z, const size_t i,
+                        const size_t lanes) -> hn::VFromD<D> {
+  if constexpr (std::is_floating_point_v<Z>) {
+    return hn::LoadN(d, z + i, lanes);
+  } else {
+    const hn::RebindToUnsigned<D> du;
+    return hn::internal::UniformFromBits(d, hn::LoadN(du, z + i, lanes));
+  }
+}
+
+/* Reproducible mode: the SR sample of element i is built from the Philox
+ * block (key, stream, i), with one key per seed and rank and one stream per
+ * thread and array op (see prism::reproducible). binary64 takes the low
+ * 64-bit word of the block and binary32 its low 32 bits. Element i then gets
+ * the same sample whatever the vector length of the target and the chunking
+ * of the array. */
+struct CounterZ {
+  std::uint64_t key;
+  std::uint64_t stream;
+  prism::sr::ConfigSnapshot config;
+};
+
+template <typename T> HWY_INLINE auto _counter_z() -> CounterZ {
+  return {prism::reproducible::key(), prism::reproducible::next_stream(),
+          prism::sr::get_config_snapshot<T>()};
+}
+
+template <class D>
+HWY_INLINE auto _load_z(const D d, const CounterZ &z, const size_t i,
+                        const size_t /*lanes*/) -> hn::VFromD<D> {
+  using T = hn::TFromD<D>;
+  const hn::ScalableTag<std::uint64_t> du64;
+  auto lo = hn::Zero(du64);
+  auto hi = hn::Zero(du64);
+  hn::VectorPhilox::Block(z.key, z.stream, i, lo, hi);
+  if constexpr (sizeof(T) == sizeof(std::uint64_t)) {
+    return pr::apply_sampling(d, hn::internal::UniformFromBits(d, lo),
+                              z.config);
+  } else {
+    const hn::RebindToUnsigned<D> du;
+#if HWY_TARGET == HWY_SCALAR
+    const auto bits = hn::Set(du, static_cast<std::uint32_t>(hn::GetLane(lo)));
+#else
+    // Low halves of the blocks i to i + Lanes(d) - 1, in order.
+    auto lo_next = hn::Zero(du64);
+    hn::VectorPhilox::Block(z.key, z.stream, i + hn::Lanes(du64), lo_next, hi);
+    const auto bits =
+        hn::ConcatEven(du, hn::BitCast(du, lo_next), hn::BitCast(du, lo));
+#endif
+    return pr::apply_sampling(d, hn::internal::UniformFromBits(d, bits),
+                              z.config);
+  }
+}
+
+/* Default mode: the SR samples are drawn from the thread's engine with its
+ * state held in registers for the whole array (see VectorXoshiro::Stream),
+ * instead of one TLS lookup and one state load and store per vector. */
+template <class Next> struct StreamZ {
+  Next &next;
+  prism::sr::ConfigSnapshot config;
+};
+
+template <class D, class Next>
+HWY_INLINE auto _load_z(const D d, const StreamZ<Next> &z, const size_t /*i*/,
+                        const size_t /*lanes*/) -> hn::VFromD<D> {
+  const hn::RebindToUnsigned<D> du;
+  const auto bits = hn::BitCast(du, z.next());
+  return pr::apply_sampling(d, hn::internal::UniformFromBits(d, bits),
+                            z.config);
+}
+
+/* Virtual precisions with their own instantiation of the SR array kernels:
+ * the hardware one, where the truncation folds away, and binary32,
+ * binary16/TF32 and bfloat16, whose truncation masks become immediates. Any
+ * other precision runs the kernel with t read from the configuration. */
+template <typename T> struct SpecializedPrecisions {};
+template <> struct SpecializedPrecisions<float> {
+  using type = std::integer_sequence<int32_t, 24, 11, 8>;
+};
+template <> struct SpecializedPrecisions<double> {
+  using type = std::integer_sequence<int32_t, 53, 24, 11, 8>;
+};
+
+template <class Kernel, int32_t... kPrecisions>
+HWY_INLINE void _dispatch_precision(
+    const int32_t t, const Kernel &kernel,
+    std::integer_sequence<int32_t, kPrecisions...> /*precisions*/) {
+  const bool specialized =
+      ((t == kPrecisions &&
+        (kernel(std::integral_constant<int32_t, kPrecisions>{}), true)) ||
+       ...);
+  if (!specialized) {
+    kernel(std::integral_constant<int32_t, pr::kRuntimePrecision>{});
+  }
+}
+
+/* Runs kernel(precision) with precision an integral_constant holding t, or
+ * kRuntimePrecision when t has no specialized instantiation. */
+template <typename T, class Kernel>
+HWY_INLINE void _with_precision(const int32_t t, const Kernel &kernel) {
+  _dispatch_precision(t, kernel, typename SpecializedPrecisions<T>::type{});
+}
+
+/* In RN mode, runs kernel(precision, t) with precision as in _with_precision
+ * and returns true; the RN array kernels need no sample. Returns false in SR
+ * mode without running it. */
+template <typename T, class Kernel>
+HWY_INLINE auto _with_rn(const Kernel &kernel) -> bool {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode != prism::sr::PRISM_RN) {
+    return false;
+  }
+  const int32_t t = config.virtual_precision;
+  _with_precision<T>(t, [&](const auto precision) { kernel(precision, t); });
+  return true;
+}
+
+/* Runs kernel(precision, z) and returns true, with z a CounterZ in
+ * reproducible mode and a StreamZ over the thread's engine otherwise.
+ * Returns false without running it when the samples are not whole random
+ * words, under a random-bit budget (chunked samples, see sample_z). Called
+ * after _with_rn, so in SR mode. */
+template <typename T, class Kernel>
+HWY_INLINE auto _with_z(const Kernel &kernel) -> bool {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  if (HWY_UNLIKELY(prism::sr::get_reproducible())) {
+    const auto z = _counter_z<T>();
+    _with_precision<T>(config.virtual_precision,
+                       [&](const auto precision) { kernel(precision, z); });
+    return true;
+  }
+  if (config.random_bits != prism::sr::PRISM_RANDOM_BITS_FULL) {
+    return false;
+  }
+  auto *engine = pr::rng::internal::get_rng();
+  _with_precision<T>(config.virtual_precision, [&](const auto precision) {
+    engine->Stream([&](auto &next) {
+      using Next = std::remove_reference_t<decltype(next)>;
+      kernel(precision, StreamZ<Next>{next, config});
+    });
+  });
+  return true;
+}
+
+// z is a pointer to the caller-supplied samples, a CounterZ or a StreamZ.
+// kPrecision is the virtual precision the kernel is instantiated for (see
+// SpecializedPrecisions), or kRuntimePrecision. The samples of a vector are
+// only loaded when one of its lanes is inexact (see round_lazy).
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _add_rand(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                           const Z z, T *HWY_RESTRICT result,
+                           const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::add<kPrecision>(d, a_vec, b_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _sub_rand(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                           const Z z, T *HWY_RESTRICT result,
+                           const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::sub<kPrecision>(d, a_vec, b_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _mul_rand(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                           const Z z, T *HWY_RESTRICT result,
+                           const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::mul<kPrecision>(d, a_vec, b_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _div_rand(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                           const Z z, T *HWY_RESTRICT result,
+                           const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::div<kPrecision>(d, a_vec, b_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _sqrt_rand(const T *HWY_RESTRICT a, const Z z,
+                            T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::sqrt<kPrecision>(d, a_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _fma_rand(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                           const T *HWY_RESTRICT c, const Z z,
+                           T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto c_vec = hn::LoadN(d, c + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res = pr::fma<kPrecision>(d, a_vec, b_vec, c_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T, typename Z>
+HWY_FLATTEN void _round_rand(const T *HWY_RESTRICT sigma,
+                             const T *HWY_RESTRICT tau, const Z z,
+                             T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+  const auto config = prism::sr::get_config_snapshot<T>();
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto sigma_vec = hn::LoadN(d, sigma + i, lanes);
+    auto tau_vec = hn::LoadN(d, tau + i, lanes);
+    const auto draw_z = [&] { return _load_z(d, z, i, lanes); };
+    auto res =
+        pr::round_lazy<kPrecision>(d, sigma_vec, tau_vec, draw_z, config);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+// RN mode kernels (see _with_rn): t is the virtual precision, kPrecision as
+// for the _rand kernels.
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _add_rn(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                         const int32_t t, T *HWY_RESTRICT result,
+                         const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto res = pr::rn::add<kPrecision>(d, a_vec, b_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _sub_rn(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                         const int32_t t, T *HWY_RESTRICT result,
+                         const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto res = pr::rn::sub<kPrecision>(d, a_vec, b_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _mul_rn(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                         const int32_t t, T *HWY_RESTRICT result,
+                         const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto res = pr::rn::mul<kPrecision>(d, a_vec, b_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _div_rn(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                         const int32_t t, T *HWY_RESTRICT result,
+                         const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto res = pr::rn::div<kPrecision>(d, a_vec, b_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _sqrt_rn(const T *HWY_RESTRICT a, const int32_t t,
+                          T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto res = pr::rn::sqrt<kPrecision>(d, a_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _fma_rn(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
+                         const T *HWY_RESTRICT c, const int32_t t,
+                         T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto a_vec = hn::LoadN(d, a + i, lanes);
+    auto b_vec = hn::LoadN(d, b + i, lanes);
+    auto c_vec = hn::LoadN(d, c + i, lanes);
+    auto res = pr::rn::fma<kPrecision>(d, a_vec, b_vec, c_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+
+template <int32_t kPrecision, typename T>
+HWY_FLATTEN void _round_rn(const T *HWY_RESTRICT sigma,
+                           const T *HWY_RESTRICT tau, const int32_t t,
+                           T *HWY_RESTRICT result, const size_t count) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const size_t N = hn::Lanes(d);
+
+  for (size_t i = 0; i < count; i += N) {
+    const size_t remaining = count - i;
+    const size_t lanes = remaining < N ? remaining : N;
+    auto sigma_vec = hn::LoadN(d, sigma + i, lanes);
+    auto tau_vec = hn::LoadN(d, tau + i, lanes);
+    auto res = pr::rn::round<kPrecision>(d, sigma_vec, tau_vec, t);
+    hn::StoreN(res, d, result + i, lanes);
+  }
+}
+#endif
+
 #if PRISM_PR_MODE == PRISM_SR_MODE
 template <typename T>
 HWY_FLATTEN void _round(const T *HWY_RESTRICT sigma, const T *HWY_RESTRICT tau,
                         T *HWY_RESTRICT result, const size_t count) {
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _round_rn<decltype(precision)::value>(sigma, tau, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _round_rand<decltype(precision)::value>(sigma, tau, z, result, count);
+      })) {
+    return;
+  }
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -78,6 +510,18 @@ HWY_INLINE void _round(const T *HWY_RESTRICT a, T *HWY_RESTRICT result,
 template <typename T>
 HWY_FLATTEN void _add(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                       T *HWY_RESTRICT result, const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _add_rn<decltype(precision)::value>(a, b, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _add_rand<decltype(precision)::value>(a, b, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -95,6 +539,18 @@ HWY_FLATTEN void _add(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
 template <typename T>
 HWY_FLATTEN void _sub(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                       T *HWY_RESTRICT result, const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _sub_rn<decltype(precision)::value>(a, b, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _sub_rand<decltype(precision)::value>(a, b, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -111,6 +567,18 @@ HWY_FLATTEN void _sub(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
 template <typename T>
 HWY_FLATTEN void _mul(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                       T *HWY_RESTRICT result, const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _mul_rn<decltype(precision)::value>(a, b, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _mul_rand<decltype(precision)::value>(a, b, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -127,6 +595,18 @@ HWY_FLATTEN void _mul(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
 template <typename T>
 HWY_FLATTEN void _div(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                       T *HWY_RESTRICT result, const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _div_rn<decltype(precision)::value>(a, b, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _div_rand<decltype(precision)::value>(a, b, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -144,6 +624,18 @@ HWY_FLATTEN void _div(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
 template <typename T>
 HWY_FLATTEN void _sqrt(const T *HWY_RESTRICT a, T *HWY_RESTRICT result,
                        const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _sqrt_rn<decltype(precision)::value>(a, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _sqrt_rand<decltype(precision)::value>(a, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -161,6 +653,18 @@ template <typename T>
 HWY_FLATTEN void _fma(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                       const T *HWY_RESTRICT c, T *HWY_RESTRICT result,
                       const size_t count) {
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn<T>([&](const auto precision, const int32_t t) {
+        _fma_rn<decltype(precision)::value>(a, b, c, t, result, count);
+      })) {
+    return;
+  }
+  if (_with_z<T>([&](const auto precision, const auto z) {
+        _fma_rand<decltype(precision)::value>(a, b, c, z, result, count);
+      })) {
+    return;
+  }
+#endif
   using D = hn::ScalableTag<T>;
   const D d{};
   const size_t N = hn::Lanes(d);
@@ -273,6 +777,78 @@ inline void _fma_f64(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
                      const size_t count) {
   _fma(a, b, c, result, count);
 }
+
+#if PRISM_PR_MODE == PRISM_SR_MODE
+/* Caller-supplied randomness specialization: _rand takes Uniform[0, 1)
+ * samples, _randbits takes random bits. In RN mode the samples are not
+ * read. */
+
+#define define_rand_unary_op(name, type, suffix, ztype)                        \
+  inline void _##name##_##suffix(const type *HWY_RESTRICT a,                  \
+                                 const ztype *HWY_RESTRICT z,                 \
+                                 type *HWY_RESTRICT result,                   \
+                                 const size_t count) {                        \
+    if (_with_rn<type>([&](const auto precision, const int32_t t) {           \
+          _##name##_rn<decltype(precision)::value>(a, t, result, count);      \
+        })) {                                                                 \
+      return;                                                                 \
+    }                                                                         \
+    _with_precision<type>(                                                    \
+        prism::sr::get_virtual_precision<type>(), [&](const auto precision) { \
+          _##name##_rand<decltype(precision)::value>(a, z, result, count);    \
+        });                                                                   \
+  }
+
+#define define_rand_bin_op(name, type, suffix, ztype)                          \
+  inline void _##name##_##suffix(                                             \
+      const type *HWY_RESTRICT a, const type *HWY_RESTRICT b,                 \
+      const ztype *HWY_RESTRICT z, type *HWY_RESTRICT result,                 \
+      const size_t count) {                                                   \
+    if (_with_rn<type>([&](const auto precision, const int32_t t) {           \
+          _##name##_rn<decltype(precision)::value>(a, b, t, result, count);   \
+        })) {                                                                 \
+      return;                                                                 \
+    }                                                                         \
+    _with_precision<type>(                                                    \
+        prism::sr::get_virtual_precision<type>(), [&](const auto precision) { \
+          _##name##_rand<decltype(precision)::value>(a, b, z, result, count); \
+        });                                                                   \
+  }
+
+#define define_rand_ter_op(name, type, suffix, ztype)                          \
+  inline void _##name##_##suffix(                                             \
+      const type *HWY_RESTRICT a, const type *HWY_RESTRICT b,                 \
+      const type *HWY_RESTRICT c, const ztype *HWY_RESTRICT z,                \
+      type *HWY_RESTRICT result, const size_t count) {                        \
+    if (_with_rn<type>([&](const auto precision, const int32_t t) {           \
+          _##name##_rn<decltype(precision)::value>(a, b, c, t, result,        \
+                                                  count);                     \
+        })) {                                                                 \
+      return;                                                                 \
+    }                                                                         \
+    _with_precision<type>(                                                    \
+        prism::sr::get_virtual_precision<type>(), [&](const auto precision) { \
+          _##name##_rand<decltype(precision)::value>(a, b, c, z, result,      \
+                                                     count);                  \
+        });                                                                   \
+  }
+
+#define define_rand_ops(type, suffix, ztype)                                   \
+  define_rand_bin_op(add, type, suffix, ztype);                                \
+  define_rand_bin_op(sub, type, suffix, ztype);                                \
+  define_rand_bin_op(mul, type, suffix, ztype);                                \
+  define_rand_bin_op(div, type, suffix, ztype);                                \
+  define_rand_unary_op(sqrt, type, suffix, ztype);                             \
+  define_rand_ter_op(fma, type, suffix, ztype)
+
+/* binary32 */
+define_rand_ops(float, rand_f32, float);
+define_rand_ops(float, randbits_f32, uint32_t);
+
+/* binary64 */
+define_rand_ops(double, rand_f64, double);
+define_rand_ops(double, randbits_f64, uint64_t);
+#endif
 } // namespace variable::HWY_NAMESPACE
 
 namespace fixed::HWY_NAMESPACE {
@@ -281,87 +857,134 @@ namespace fixed::HWY_NAMESPACE {
 namespace hn = hwy::HWY_NAMESPACE;
 namespace pr = PRISM_PR_MODE_NAMESPACE::PRISM_DISPATCH::HWY_NAMESPACE;
 
+/* Stores op(d, va...) to result for each vector va... of the N elements of
+ * args..., loaded in as few vectors as possible, so that an SR kernel draws
+ * one vector of samples for up to Lanes(d) elements. */
+template <typename T, std::size_t N, class Op, class... Args>
+HWY_INLINE void _map_xN(T *HWY_RESTRICT result, const Op &op,
+                        const Args *HWY_RESTRICT... args) {
+  using D = hn::ScalableTag<T>;
+  const D d{};
+  const std::size_t lanes = hn::Lanes(d);
+  for (std::size_t i = 0; i < N; i += lanes) {
+    const std::size_t remaining = N - i < lanes ? N - i : lanes;
+    hn::StoreN(op(d, hn::LoadN(d, args + i, remaining)...), d, result + i,
+               remaining);
+  }
+}
+
+#if PRISM_PR_MODE == PRISM_SR_MODE
+/* In RN mode, runs _map_xN with op(d, va..., t), t being the virtual
+ * precision read once for the N elements, and returns true. Returns false in
+ * SR mode without running op. */
+template <typename T, std::size_t N, class Op, class... Args>
+HWY_INLINE auto _with_rn_fixed(T *HWY_RESTRICT result, const Op &op,
+                               const Args *HWY_RESTRICT... args) -> bool {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode != prism::sr::PRISM_RN) {
+    return false;
+  }
+  const int32_t t = config.virtual_precision;
+  _map_xN<T, N>(
+      result, [&](const auto d, const auto... v) { return op(d, v..., t); },
+      args...);
+  return true;
+}
+#endif
+
 template <typename T, std::size_t N>
 HWY_FLATTEN void _addxN(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                         T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    const auto vb = hn::Set(d, b[i]);
-    auto res = pr::add(d, va, vb);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::add(d, v...); },
+          a, b)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::add(d, v...); },
+      a, b);
 }
 
 template <typename T, std::size_t N>
 HWY_FLATTEN void _subxN(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                         T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    const auto vb = hn::Set(d, b[i]);
-    auto res = pr::sub(d, va, vb);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::sub(d, v...); },
+          a, b)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::sub(d, v...); },
+      a, b);
 }
 
 template <typename T, std::size_t N>
 HWY_FLATTEN void _mulxN(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                         T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    const auto vb = hn::Set(d, b[i]);
-    auto res = pr::mul(d, va, vb);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::mul(d, v...); },
+          a, b)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::mul(d, v...); },
+      a, b);
 }
 
 template <typename T, std::size_t N>
 HWY_FLATTEN void _divxN(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                         T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    const auto vb = hn::Set(d, b[i]);
-    auto res = pr::div(d, va, vb);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::div(d, v...); },
+          a, b)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::div(d, v...); },
+      a, b);
 }
 
 template <typename T, std::size_t N>
 HWY_FLATTEN void _sqrtxN(const T *HWY_RESTRICT a, T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    auto res = pr::sqrt(d, va);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::sqrt(d, v...); },
+          a)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::sqrt(d, v...); },
+      a);
 }
 
 template <typename T, std::size_t N>
 HWY_FLATTEN void _fmaxN(const T *HWY_RESTRICT a, const T *HWY_RESTRICT b,
                         const T *HWY_RESTRICT c, T *HWY_RESTRICT result) {
-  // Use element-wise processing for all targets to avoid FixedTag limitations
-  for (std::size_t i = 0; i < N; ++i) {
-    using D = hn::ScalableTag<T>;
-    const D d{};
-    const auto va = hn::Set(d, a[i]);
-    const auto vb = hn::Set(d, b[i]);
-    const auto vc = hn::Set(d, c[i]);
-    auto res = pr::fma(d, va, vb, vc);
-    result[i] = hn::GetLane(res);
+#if PRISM_PR_MODE == PRISM_SR_MODE
+  if (_with_rn_fixed<T, N>(
+          result,
+          [](const auto d, const auto... v) { return pr::rn::fma(d, v...); },
+          a, b, c)) {
+    return;
   }
+#endif
+  _map_xN<T, N>(
+      result, [](const auto d, const auto... v) { return pr::fma(d, v...); },
+      a, b, c);
 }
 
 /* _<op>x<size>_<type> */
@@ -495,6 +1118,21 @@ HWY_EXPORT(_div_f64);
 HWY_EXPORT(_sqrt_f64);
 HWY_EXPORT(_fma_f64);
 
+#if PRISM_PR_MODE == PRISM_SR_MODE
+#define export_rand_ops(suffix)                                                \
+  HWY_EXPORT(_add_##suffix);                                                   \
+  HWY_EXPORT(_sub_##suffix);                                                   \
+  HWY_EXPORT(_mul_##suffix);                                                   \
+  HWY_EXPORT(_div_##suffix);                                                   \
+  HWY_EXPORT(_sqrt_##suffix);                                                  \
+  HWY_EXPORT(_fma_##suffix)
+
+export_rand_ops(rand_f32);
+export_rand_ops(randbits_f32);
+export_rand_ops(rand_f64);
+export_rand_ops(randbits_f64);
+#endif
+
 } // namespace
 
 /* Variable size functions */
@@ -591,6 +1229,53 @@ void fmaf64(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
   return HWY_DYNAMIC_DISPATCH(_fma_f64)(a, b, c, result, count);
 }
 
+#if PRISM_PR_MODE == PRISM_SR_MODE
+/* Caller-supplied randomness */
+
+#define define_rand_ops_dynamic(type, size, name, ztype)                       \
+  void add##size##_##name(const type *HWY_RESTRICT a,                          \
+                          const type *HWY_RESTRICT b,                          \
+                          const ztype *HWY_RESTRICT z,                         \
+                          type *HWY_RESTRICT result, const size_t count) {     \
+    return HWY_DYNAMIC_DISPATCH(_add_##name##_##size)(a, b, z, result, count); \
+  }                                                                            \
+  void sub##size##_##name(const type *HWY_RESTRICT a,                          \
+                          const type *HWY_RESTRICT b,                          \
+                          const ztype *HWY_RESTRICT z,                         \
+                          type *HWY_RESTRICT result, const size_t count) {     \
+    return HWY_DYNAMIC_DISPATCH(_sub_##name##_##size)(a, b, z, result, count); \
+  }                                                                            \
+  void mul##size##_##name(const type *HWY_RESTRICT a,                          \
+                          const type *HWY_RESTRICT b,                          \
+                          const ztype *HWY_RESTRICT z,                         \
+                          type *HWY_RESTRICT result, const size_t count) {     \
+    return HWY_DYNAMIC_DISPATCH(_mul_##name##_##size)(a, b, z, result, count); \
+  }                                                                            \
+  void div##size##_##name(const type *HWY_RESTRICT a,                          \
+                          const type *HWY_RESTRICT b,                          \
+                          const ztype *HWY_RESTRICT z,                         \
+                          type *HWY_RESTRICT result, const size_t count) {     \
+    return HWY_DYNAMIC_DISPATCH(_div_##name##_##size)(a, b, z, result, count); \
+  }                                                                            \
+  void sqrt##size##_##name(const type *HWY_RESTRICT a,                         \
+                           const ztype *HWY_RESTRICT z,                        \
+                           type *HWY_RESTRICT result, const size_t count) {    \
+    return HWY_DYNAMIC_DISPATCH(_sqrt_##name##_##size)(a, z, result, count);   \
+  }                                                                            \
+  void fma##size##_##name(                                                     \
+      const type *HWY_RESTRICT a, const type *HWY_RESTRICT b,                  \
+      const type *HWY_RESTRICT c, const ztype *HWY_RESTRICT z,                 \
+      type *HWY_RESTRICT result, const size_t count) {                         \
+    return HWY_DYNAMIC_DISPATCH(_fma_##name##_##size)(a, b, c, z, result,      \
+                                                      count);                  \
+  }
+
+define_rand_ops_dynamic(float, f32, rand, float);
+define_rand_ops_dynamic(float, f32, randbits, uint32_t);
+define_rand_ops_dynamic(double, f64, rand, double);
+define_rand_ops_dynamic(double, f64, randbits, uint64_t);
+#endif
+
 /* Single vector instructions with dynamic dispatch */
 
 #define define_array_unary_op_dynamic(name, count)                             \
@@ -10,6 +10,8 @@
  *                                                                           *\
  ****************************************************************************/
 
+#include <cstring>
+
 #include "prism_api.h"
 #include "utils.h"
 #include "xoshiro.h"
@@ -54,6 +56,18 @@ uint64_t interflop_prism_get_seed(void) { return get_user_seed(); }
 
 void interflop_prism_set_seed(uint64_t seed) { set_user_seed(seed); }
 
+void interflop_prism_bind_rng_stream(uint64_t index) {
+  prism::rng_stream::bind(index);
+}
+
+uint64_t interflop_prism_get_rng_stream(void) { return get_thread_id(); }
+
+void interflop_prism_set_rank(uint64_t rank) {
+  prism::rng_stream::set_rank(rank);
+}
+
+uint64_t interflop_prism_get_rank(void) { return prism::rng_stream::get_rank(); }
+
 void interflop_prism_set_rounding_mode(int32_t mode) {
   prism::sr::set_default_rounding_mode(mode);
 }
@@ -66,4 +80,78 @@ void interflop_prism_set_thread_rounding_mode(int32_t mode) {
   prism::sr::set_rounding_mode(mode);
 }
 
+void interflop_prism_set_random_bits(int32_t bits) {
+  prism::sr::set_default_random_bits(bits);
+}
+
+int32_t interflop_prism_get_random_bits(void) {
+  return prism::sr::get_random_bits();
+}
+
+void interflop_prism_set_thread_random_bits(int32_t bits) {
+  prism::sr::set_random_bits(bits);
+}
+
+void interflop_prism_set_sr_sampling(int32_t sampling, uint64_t run) {
+  prism::sr::set_default_sampling(sampling, run);
+  // The stream seed depends on the scheme and the run: like a reseed, every
+  // thread restarts on its stream of the new stream seed.
+  seed_epoch.fetch_add(1, std::memory_order_release);
+}
+
+int32_t interflop_prism_get_sr_sampling(void) {
+  return prism::sr::get_sampling();
+}
+
+uint64_t interflop_prism_get_sr_run(void) { return prism::sr::get_sr_run(); }
+
+void interflop_prism_set_sr_reproducible(int32_t enable) {
+  prism::sr::set_default_reproducible(enable != 0);
+}
+
+int32_t interflop_prism_get_sr_reproducible(void) {
+  return static_cast<int32_t>(prism::sr::get_reproducible());
+}
+
+void interflop_prism_set_rng_cache_size(uint64_t words) {
+  prism::rng_cache::set_cache_size(words);
+}
+
+uint64_t interflop_prism_get_rng_cache_size(void) {
+  return prism::rng_cache::get_cache_size();
+}
+
+uint64_t interflop_prism_get_rng_state_size(void) {
+  return prism::rng_snapshot::save().size();
+}
+
+uint64_t interflop_prism_save_rng_state(void *buffer, uint64_t size) {
+  const auto snapshot = prism::rng_snapshot::save();
+  if (buffer == nullptr || size < snapshot.size()) {
+    return 0;
+  }
+  std::memcpy(buffer, snapshot.data(), snapshot.size());
+  return snapshot.size();
+}
+
+int32_t interflop_prism_restore_rng_state(const void *buffer, uint64_t size) {
+  if (buffer == nullptr) {
+    return -1;
+  }
+  return prism::rng_snapshot::restore(buffer, size) ? 0 : -1;
+}
+
+void interflop_prism_get_rng_pool_stats(uint64_t *hits, uint64_t *misses) {
+  if (hits != nullptr) {
+    *hits = prism::state_pool::hits.load(std::memory_order_relaxed);
+  }
+  if (misses != nullptr) {
+    *misses = prism::state_pool::misses.load(std::memory_order_relaxed);
+  }
+}
+
+uint64_t interflop_prism_get_sr_exact_vectors(void) {
+  return prism::sr::exact_vectors.load(std::memory_order_relaxed);
+}
+
 } // extern "C"
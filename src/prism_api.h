@@ -38,8 +38,29 @@ void interflop_prism_set_thread_virtual_precision_binary32(int32_t t);
 void interflop_prism_set_thread_virtual_precision_binary64(int32_t t);
 
 uint64_t interflop_prism_get_seed(void);
+/* Process-wide. Every thread, including threads that already drew random
+ * numbers, restarts on its stream of the new seed at its next draw, so
+ * several SR samples can run in one process. */
 void interflop_prism_set_seed(uint64_t seed);
 
+/* Binds the calling thread to the random stream index, so that streams are
+ * assigned by the program (e.g. the OpenMP thread number) rather than by the
+ * order in which threads first draw. The thread restarts at the beginning of
+ * that stream on its next draw; binding again to the same index is a no-op.
+ * Bind every thread that draws, with distinct indices. */
+void interflop_prism_bind_rng_stream(uint64_t index);
+/* Stream index of the calling thread. */
+uint64_t interflop_prism_get_rng_stream(void);
+
+/* Rank of the process in a multi-process job, read from PRISM_RANK,
+ * OMPI_COMM_WORLD_RANK, PMI_RANK or SLURM_PROCID (0 if none is set). Thread
+ * stream i of rank r is stream r * 2^32 + i, so one seed gives
+ * non-overlapping streams to every thread of every rank; thread streams are
+ * taken modulo 2^32. Process-wide; every thread restarts on its stream of the
+ * new rank at its next draw, as for a reseed. */
+void interflop_prism_set_rank(uint64_t rank);
+uint64_t interflop_prism_get_rank(void);
+
 /* Rounding modes */
 #define INTERFLOP_PRISM_SR 0
 #define INTERFLOP_PRISM_RN 1
@@ -51,6 +72,72 @@ int32_t interflop_prism_get_rounding_mode(void);
 /* Per-thread override, in effect until the next process-wide set. */
 void interflop_prism_set_thread_rounding_mode(int32_t mode);
 
+/* Random-bit budget of the SR sample: number of random bits drawn per lane,
+ * 0 for a full-precision uniform, otherwise 1, 2, 4, 8 or 16. Fewer bits make
+ * one random word serve more lanes at the price of a rounding-probability
+ * bias bounded by 2^-(bits + 1). Process-wide, like the setters above. */
+void interflop_prism_set_random_bits(int32_t bits);
+/* Budget the calling thread will actually draw with. */
+int32_t interflop_prism_get_random_bits(void);
+/* Per-thread override, in effect until the next process-wide set. */
+void interflop_prism_set_thread_random_bits(int32_t bits);
+
+/* SR sampling across runs */
+#define INTERFLOP_PRISM_SAMPLING_MC 0
+#define INTERFLOP_PRISM_SAMPLING_ANTITHETIC 1
+#define INTERFLOP_PRISM_SAMPLING_QMC 2
+
+/* Correlates the SR samples of repeated runs of a program to reduce the
+ * variance of statistics computed over the runs: MC draws independent
+ * samples, ANTITHETIC pairs runs 2k and 2k + 1 on z and (1 - 2^-p) - z, p
+ * the mantissa width, QMC shifts one shared stream by the van der Corput point
+ * of the run index. run is the index
+ * of this run (PRISM_SR_SAMPLING and PRISM_SR_RUN by default). Keep the seed
+ * fixed across the runs. Process-wide; every thread restarts on its stream of
+ * the new scheme at its next draw, as for a reseed. */
+void interflop_prism_set_sr_sampling(int32_t sampling, uint64_t run);
+int32_t interflop_prism_get_sr_sampling(void);
+uint64_t interflop_prism_get_sr_run(void);
+
+/* Reproducible SR: the sample of element i of an array function depends only
+ * on the seed, the thread, the number of array calls made by the thread since
+ * the last reseed and i, so that results are bit-identical across dispatch
+ * targets (PRISM_SR_REPRODUCIBLE by default). Scalar and fixed-size functions
+ * are not affected. Process-wide. */
+void interflop_prism_set_sr_reproducible(int32_t enable);
+int32_t interflop_prism_get_sr_reproducible(void);
+
+/* Capacity, in 64-bit words, of the per-thread scalar RNG cache: a power of 2
+ * between 256 and 2^20 (default 8192, or PRISM_RNG_CACHE_SIZE). The cache
+ * starts small and grows to this capacity as the thread draws numbers.
+ * Applies to the RNG states created after the call; invalid sizes are
+ * ignored. */
+void interflop_prism_set_rng_cache_size(uint64_t words);
+uint64_t interflop_prism_get_rng_cache_size(void);
+
+/* Snapshot of the random generator state of the calling thread (engine
+ * state, scalar cache, partially consumed random words). Restoring it, in
+ * any thread, replays the exact same random numbers from that point, e.g. to
+ * rerun one phase of a program. A snapshot is only valid for the same build
+ * and SIMD target. */
+uint64_t interflop_prism_get_rng_state_size(void);
+/* Returns the number of bytes written, or 0 if size is too small. */
+uint64_t interflop_prism_save_rng_state(void *buffer, uint64_t size);
+/* Returns 0, or -1 if buffer does not hold a snapshot of this build and
+ * target, in which case the state is left unchanged. */
+int32_t interflop_prism_restore_rng_state(const void *buffer, uint64_t size);
+
+/* Debug: RNG states adopted from exited threads (hits) and created from
+ * scratch (misses) since the start of the process. Recycling can be disabled
+ * with PRISM_RNG_RECYCLE=0. Either pointer may be NULL. */
+void interflop_prism_get_rng_pool_stats(uint64_t *hits, uint64_t *misses);
+
+/* Debug: vectors of results that the SR vector functions returned without
+ * drawing a sample because every lane was exact at the virtual precision,
+ * since the start of the process. Counted only in PRISM_DEBUG builds (the
+ * -dbg libraries); 0 otherwise. */
+uint64_t interflop_prism_get_sr_exact_vectors(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
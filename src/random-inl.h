@@ -23,7 +23,10 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "hwy/highway.h"
 
@@ -40,32 +43,102 @@ namespace HWY_NAMESPACE { // required: unique per target
 
 namespace dbg = prism::vector::HWY_NAMESPACE;
 
-constexpr uint32_t expF32 = prism::utils::IEEE754<float>::exponent;
-constexpr uint64_t expF64 = prism::utils::IEEE754<double>::exponent;
-
 namespace internal {
 
 namespace {
-#if HWY_HAVE_FLOAT64
-// C++ < 17 does not support hexfloat
-#if __cpp_hex_float > 201603L
-constexpr double kMulConst = 0x1.0p-53;
-constexpr float kMulConstF = 0x1.0p-24f;
-#else
-constexpr double kMulConst =
-    0.00000000000000011102230246251565404236316680908203125;
-constexpr float kMulConstF = 0.000000059604644775390625F;
-#endif // __cpp_hex_float
-
-#endif // HWY_HAVE_FLOAT64
-
 constexpr std::uint64_t kJump[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
                                    0xa9582618e03fc9aa, 0x39abdc4529b1661c};
 
 constexpr std::uint64_t kLongJump[] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3,
                                        0x77710069854ee241, 0x39109bb02acbe635};
+
+/* Characteristic polynomial of the xoshiro256 linear engine, without its
+ * leading x^256 term. As for kJump, bit b of word i is the coefficient of
+ * x^(64 * i + b). kJump and kLongJump are x^(2^128) and x^(2^192) modulo
+ * this polynomial. */
+constexpr std::uint64_t kCharPoly[] = {0x9d116f2bb0f0f001, 0x0280002bcefd1a5e,
+                                       0x04b4edcf26259f85, 0x0003c03c3f3ecb19};
+
+// Philox4x32-10 multipliers and Weyl key increments (Salmon et al., 2011).
+constexpr std::uint64_t kPhiloxM0 = 0xD2511F53;
+constexpr std::uint64_t kPhiloxM1 = 0xCD9E8D57;
+constexpr std::uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr std::uint32_t kPhiloxW1 = 0xBB67AE85;
+constexpr int kPhiloxRounds = 10;
+// ARS-7: Weyl increments of the round keys (golden ratio, sqrt(3) - 1) and
+// number of AES rounds.
+constexpr std::uint64_t kArsW0 = 0x9E3779B97F4A7C15;
+constexpr std::uint64_t kArsW1 = 0xBB67AE8584CAA73B;
+constexpr int kArsRounds = 7;
 } // namespace
 
+using JumpPoly = std::array<std::uint64_t, 4>;
+
+/* Product of two jump polynomials modulo the characteristic polynomial. */
+inline auto JumpPolyMulMod(const JumpPoly &a,
+                           const JumpPoly &b) noexcept -> JumpPoly {
+  JumpPoly result{};
+  JumpPoly x = a;
+  for (std::size_t i = 0; i < 256; ++i) {
+    if ((b[i / 64] >> (i % 64)) & 1) {
+      for (std::size_t j = 0; j < 4; ++j) {
+        result[j] ^= x[j];
+      }
+    }
+    // x <- x * X mod P
+    const std::uint64_t carry = x[3] >> 63;
+    x[3] = (x[3] << 1) | (x[2] >> 63);
+    x[2] = (x[2] << 1) | (x[1] >> 63);
+    x[1] = (x[1] << 1) | (x[0] >> 63);
+    x[0] = x[0] << 1;
+    if (carry) {
+      for (std::size_t j = 0; j < 4; ++j) {
+        x[j] ^= kCharPoly[j];
+      }
+    }
+  }
+  return result;
+}
+
+constexpr std::size_t kJumpTableSize = 128;
+
+/* Jump polynomials for power-of-two jump distances: entry i is
+ * x^(2^(128 + i)) mod P, i.e. 2^i calls to Jump(). Entry 0 is kJump and
+ * entry 64 is kLongJump. Built once by repeated squaring. */
+inline auto GetJumpTable() -> const std::array<JumpPoly, kJumpTableSize> & {
+  static const auto table = [] {
+    std::array<JumpPoly, kJumpTableSize> t{};
+    t[0] = {kJump[0], kJump[1], kJump[2], kJump[3]};
+    for (std::size_t i = 1; i < kJumpTableSize; ++i) {
+      t[i] = JumpPolyMulMod(t[i - 1], t[i - 1]);
+    }
+    return t;
+  }();
+  return table;
+}
+
+/* Uniform in [0, 1) built without an integer-to-float conversion: the top
+ * mantissa-width random bits are OR-ed into the bit pattern of 1.0, which
+ * gives a value in [1, 2), and 1 is subtracted (exact). The resolution is
+ * 2^-23 for binary32 and 2^-52 for binary64. */
+template <typename T, typename U = MakeUnsigned<T>>
+HWY_INLINE auto UniformFromBits(const U bits) noexcept -> T {
+  constexpr int kShift = sizeof(T) * 8 - prism::utils::IEEE754<T>::mantissa;
+  const U one = BitCastScalar<U>(T{1});
+  return BitCastScalar<T>(static_cast<U>((bits >> kShift) | one)) - T{1};
+}
+
+template <class DF, class VU>
+HWY_INLINE auto UniformFromBits(const DF df,
+                                const VU bits) noexcept -> VFromD<DF> {
+  using T = TFromD<DF>;
+  constexpr int kShift = sizeof(T) * 8 - prism::utils::IEEE754<T>::mantissa;
+  const RebindToUnsigned<DF> du;
+  const auto one = Set(df, T{1});
+  const auto mantissa = ShiftRight<kShift>(bits);
+  return Sub(BitCast(df, Or(mantissa, BitCast(du, one))), one);
+}
+
 class SplitMix64 {
 public:
   constexpr explicit SplitMix64(const std::uint64_t state) noexcept
@@ -92,12 +165,10 @@ public:
     }
   }
 
-  HWY_CXX14_CONSTEXPR explicit Xoshiro(const std::uint64_t seed,
-                                       const std::uint64_t thread_id) noexcept
+  explicit Xoshiro(const std::uint64_t seed,
+                   const std::uint64_t thread_id) noexcept
       : Xoshiro(seed) {
-    for (auto i = UINT64_C(0); i < thread_id; ++i) {
-      Jump();
-    }
+    Jump(thread_id);
   }
 
   HWY_CXX14_CONSTEXPR auto operator()() noexcept -> std::uint64_t {
@@ -105,9 +176,7 @@ public:
   }
 
 #if HWY_HAVE_FLOAT64
-  HWY_CXX14_CONSTEXPR auto Uniform() noexcept -> double {
-    return static_cast<double>(Next() >> expF64) * kMulConst;
-  }
+  auto Uniform() noexcept -> double { return UniformFromBits<double>(Next()); }
 #endif
 
   HWY_CXX14_CONSTEXPR auto GetState() const -> std::array<std::uint64_t, 4> {
@@ -135,20 +204,40 @@ public:
    * parallel distributed computations. */
   HWY_CXX14_CONSTEXPR void LongJump() noexcept { Jump(kLongJump); }
 
-  HWY_CXX14_CONSTEXPR auto
-  UniformVec(const float /*unused*/) noexcept -> double {
+  /* Equivalent to n calls to Jump(). Applies the precomputed jump polynomial
+   * of each bit set in n, so the cost is O(popcount(n)) instead of O(n). */
+  void Jump(const std::uint64_t n) noexcept {
+    const auto &table = GetJumpTable();
+    for (std::size_t i = 0; i < 64; ++i) {
+      if ((n >> i) & 1) {
+        Jump(table[i]);
+      }
+    }
+  }
+
+  /* Equivalent to n calls to LongJump(). */
+  void LongJump(const std::uint64_t n) noexcept {
+    const auto &table = GetJumpTable();
+    for (std::size_t i = 0; i < 64; ++i) {
+      if ((n >> i) & 1) {
+        Jump(table[64 + i]);
+      }
+    }
+  }
+
+  auto UniformVec(const float /*unused*/) noexcept -> double {
     union {
       std::uint64_t u64;
       std::array<std::uint32_t, 2> u32;
       double f64;
       std::array<float, 2> f32;
     } u{Next()};
-    u.f32[0] = (u.u32[0] >> expF32) * kMulConstF;
-    u.f32[1] = (u.u32[1] >> expF32) * kMulConstF;
+    u.f32[0] = UniformFromBits<float>(u.u32[0]);
+    u.f32[1] = UniformFromBits<float>(u.u32[1]);
     return u.f64;
   }
 
-  HWY_CXX14_CONSTEXPR auto UniformVec(const double) noexcept -> double {
+  auto UniformVec(const double) noexcept -> double {
     return Uniform();
   }
 
@@ -177,7 +266,11 @@ private:
     return result;
   }
 
-  HWY_CXX14_CONSTEXPR void Jump(const std::uint64_t (&jumpArray)[4]) noexcept {
+  HWY_CXX17_CONSTEXPR void Jump(const std::uint64_t (&jumpArray)[4]) noexcept {
+    Jump(JumpPoly{jumpArray[0], jumpArray[1], jumpArray[2], jumpArray[3]});
+  }
+
+  HWY_CXX17_CONSTEXPR void Jump(const JumpPoly &jumpArray) noexcept {
     std::uint64_t s0 = 0;
     std::uint64_t s1 = 0;
     std::uint64_t s2 = 0;
@@ -202,6 +295,77 @@ private:
   }
 };
 
+/* Byte stream holding a snapshot of generator states (SaveState /
+ * RestoreState). The layout is that of the current target and build, it is
+ * not meant to be portable. */
+class StateWriter {
+public:
+  explicit StateWriter(std::vector<std::uint8_t> &out) : out_{&out} {}
+
+  template <typename T> void Put(const T *HWY_RESTRICT data, std::size_t n) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "StateWriter: T must be trivially copyable");
+    const auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+    out_->insert(out_->end(), bytes, bytes + n * sizeof(T));
+  }
+
+  template <typename T> void Put(const T &value) { Put(&value, 1); }
+
+private:
+  std::vector<std::uint8_t> *out_;
+};
+
+class StateReader {
+public:
+  StateReader(const std::uint8_t *data, const std::size_t size)
+      : pos_{data}, end_{data + size} {}
+
+  // Fails, and keeps failing, once the stream is exhausted.
+  template <typename T> auto Get(T *HWY_RESTRICT data, std::size_t n) -> bool {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "StateReader: T must be trivially copyable");
+    const std::size_t bytes = n * sizeof(T);
+    if (!ok_ || static_cast<std::size_t>(end_ - pos_) < bytes) {
+      ok_ = false;
+      return false;
+    }
+    std::memcpy(data, pos_, bytes);
+    pos_ += bytes;
+    return true;
+  }
+
+  template <typename T> auto Get(T &value) -> bool { return Get(&value, 1); }
+
+  // The whole stream was read, and nothing more.
+  [[nodiscard]] auto Done() const -> bool { return ok_ && pos_ == end_; }
+
+private:
+  const std::uint8_t *pos_;
+  const std::uint8_t *end_;
+  bool ok_{true};
+};
+
+// Engine identifiers written in front of a state snapshot.
+constexpr std::uint64_t kXoshiroStateId = 1;
+constexpr std::uint64_t kPhiloxStateId = 2;
+constexpr std::uint64_t kAESStateId = 3;
+
+/* Stores n values at data, which need not be aligned, taken from successive
+ * vectors next(). The last vector is stored partially and its other lanes are
+ * dropped, so any n is accepted and nothing is written past data + n. */
+template <class D, class Next>
+HWY_INLINE void StoreVectors(const D d, TFromD<D> *HWY_RESTRICT data,
+                             const std::size_t n, Next &&next) {
+  const std::size_t lanes = Lanes(d);
+  std::size_t i = 0;
+  for (; i + lanes <= n; i += lanes) {
+    StoreU(next(), d, data + i);
+  }
+  if (i < n) {
+    StoreN(next(), d, data + i, n - i);
+  }
+}
+
 } // namespace internal
 
 class VectorXoshiro {
@@ -221,10 +385,7 @@ public:
                 Lanes(ScalableTag<std::uint64_t>{})}},
         streams{state_.shape().back()} {
     internal::Xoshiro xoshiro{seed};
-
-    for (std::uint64_t i = 0; i < threadNumber; ++i) {
-      xoshiro.LongJump();
-    }
+    xoshiro.LongJump(threadNumber);
 
     for (size_t i = 0UL; i < streams; ++i) {
       const auto state = xoshiro.GetState();
@@ -341,41 +502,83 @@ public:
   }
 
   template <std::uint64_t N> void fill(std::uint64_t *HWY_RESTRICT data) {
+    fill(data, N);
+  }
+
+  /* Caller-buffer variants: write n values of any count to data, at any
+   * alignment, without allocating. Each vector yields Lanes(ScalableTag<T>)
+   * values; the lanes of the last vector beyond n are dropped. The state
+   * stays in registers for the whole buffer. */
+  void fill(std::uint64_t *HWY_RESTRICT data, const std::size_t n) {
+    FillWith(ScalableTag<std::uint64_t>{}, data, n,
+             [](const VU64 bits) { return bits; });
+  }
+
+  void fill(std::uint32_t *HWY_RESTRICT data, const std::size_t n) {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    FillWith(u32_tag, data, n,
+             [u32_tag](const VU64 bits) { return BitCast(u32_tag, bits); });
+  }
+
+  void FillUniform(float *HWY_RESTRICT data, const std::size_t n) {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    const ScalableTag<float> real_tag{};
+    FillWith(real_tag, data, n, [u32_tag, real_tag](const VU64 bits) {
+      return internal::UniformFromBits(real_tag, BitCast(u32_tag, bits));
+    });
+  }
+
+  template <std::uint64_t N> void FillUniform(float *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+
+#if HWY_HAVE_FLOAT64
+  void FillUniform(double *HWY_RESTRICT data, const std::size_t n) {
+    const ScalableTag<double> real_tag{};
+    FillWith(real_tag, data, n, [real_tag](const VU64 bits) {
+      return internal::UniformFromBits(real_tag, bits);
+    });
+  }
+
+  template <std::uint64_t N> void FillUniform(double *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+#endif
+
+  [[nodiscard]] auto StateSize() const noexcept -> std::uint64_t {
+    return streams * internal::Xoshiro::StateSize();
+  }
+
+  [[nodiscard]] auto GetState() const -> const StateType & { return state_; }
+
+  /* Runs body(next), where next() returns the next random vector. The state
+   * vectors stay in registers for the whole body: they are loaded once before
+   * it and stored back once after it. The engine must not be used otherwise
+   * inside body. */
+  template <class Body> HWY_INLINE void Stream(const Body &body) {
     const ScalableTag<std::uint64_t> tag{};
     auto s0 = Load(tag, state_[{0}].data());
     auto s1 = Load(tag, state_[{1}].data());
     auto s2 = Load(tag, state_[{2}].data());
     auto s3 = Load(tag, state_[{3}].data());
-    for (std::uint64_t i = 0; i < N; i += Lanes(tag)) {
-      const auto next = Update(s0, s1, s2, s3);
-      Store(next, tag, data + i);
-    }
+    auto next = [&] { return Update(s0, s1, s2, s3); };
+    body(next);
     Store(s0, tag, state_[{0}].data());
     Store(s1, tag, state_[{1}].data());
     Store(s2, tag, state_[{2}].data());
     Store(s3, tag, state_[{3}].data());
   }
 
-  [[nodiscard]] auto StateSize() const noexcept -> std::uint64_t {
-    return streams * internal::Xoshiro::StateSize();
-  }
-
-  [[nodiscard]] auto GetState() const -> const StateType & { return state_; }
-
   HWY_INLINE auto Uniform(float) noexcept -> VF32 {
     dbg::debug_msg("\n[VectorXoshiro] START Uniform<float>");
     const ScalableTag<std::uint64_t> tag{};
     const ScalableTag<std::uint32_t> u32_tag{};
     const ScalableTag<float> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConstF);
     const auto bits = Next();
     const auto bitscast = BitCast(u32_tag, bits);
     dbg::debug_vec(tag, "[VectorXoshiro] bits", bits);
     dbg::debug_vec(u32_tag, "[VectorXoshiro] u32 bits", bitscast);
-    const auto bitsshift = ShiftRight<expF32>(bitscast);
-    const auto real = ConvertTo(real_tag, bitsshift);
-    dbg::debug_vec(real_tag, "[VectorXoshiro] real", real);
-    const auto res = Mul(real, MUL_VALUE);
+    const auto res = internal::UniformFromBits(real_tag, bitscast);
     dbg::debug_vec(real_tag, "[VectorXoshiro] res", res);
     return res;
   }
@@ -387,7 +590,6 @@ public:
     const ScalableTag<std::uint32_t> u32_tag{};
     const ScalableTag<std::uint64_t> tag{};
     const ScalableTag<float> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConstF);
 
     auto s0 = Load(tag, state_[{0}].data());
     auto s1 = Load(tag, state_[{1}].data());
@@ -397,12 +599,9 @@ public:
     for (std::size_t i = 0; i < n; i += Lanes(real_tag)) {
       const auto next = Update(s0, s1, s2, s3);
       const auto bits = BitCast(u32_tag, next);
-      const auto bitscast = ShiftRight<expF32>(bits);
-      const auto real = ConvertTo(real_tag, bitscast);
-      const auto uniform = Mul(real, MUL_VALUE);
+      const auto uniform = internal::UniformFromBits(real_tag, bits);
       dbg::debug_vec(tag, "[VectorXoshiro] bits", next);
-      dbg::debug_vec(u32_tag, "[VectorXoshiro] bits u32", bitscast);
-      dbg::debug_vec(real_tag, "[VectorXoshiro] real", real);
+      dbg::debug_vec(u32_tag, "[VectorXoshiro] bits u32", bits);
       dbg::debug_vec(real_tag, "[VectorXoshiro] uniform", uniform);
       Store(uniform, real_tag, result.data() + i);
     }
@@ -420,7 +619,6 @@ public:
     const ScalableTag<std::uint32_t> u32_tag{};
     const ScalableTag<std::uint64_t> tag{};
     const ScalableTag<float> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConstF);
 
     auto s0 = Load(tag, state_[{0}].data());
     auto s1 = Load(tag, state_[{1}].data());
@@ -430,9 +628,7 @@ public:
     for (std::uint32_t i = 0; i < N; i += Lanes(real_tag)) {
       const auto next = Update(s0, s1, s2, s3);
       const auto bits = BitCast(u32_tag, next);
-      const auto bitscast = ShiftRight<expF32>(bits);
-      const auto real = ConvertTo(real_tag, bitscast);
-      const auto uniform = Mul(real, MUL_VALUE);
+      const auto uniform = internal::UniformFromBits(real_tag, bits);
       Store(uniform, real_tag, result.data() + i);
     }
 
@@ -447,11 +643,7 @@ public:
 
   auto Uniform(double /*unused*/) noexcept -> VF64 {
     const ScalableTag<double> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConst);
-    const auto bits = Next();
-    const auto bits_s = ShiftRight<expF64>(bits);
-    const auto real = ConvertTo(real_tag, bits_s);
-    return Mul(real, MUL_VALUE);
+    return internal::UniformFromBits(real_tag, Next());
   }
 
   auto Uniform(double /*unused*/,
@@ -459,7 +651,6 @@ public:
     AlignedVector<double> result(n);
     const ScalableTag<std::uint64_t> tag{};
     const ScalableTag<double> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConst);
 
     auto s0 = Load(tag, state_[{0}].data());
     auto s1 = Load(tag, state_[{1}].data());
@@ -468,9 +659,7 @@ public:
 
     for (std::size_t i = 0; i < n; i += Lanes(real_tag)) {
       const auto next = Update(s0, s1, s2, s3);
-      const auto bits = ShiftRight<expF64>(next);
-      const auto real = ConvertTo(real_tag, bits);
-      const auto uniform = Mul(real, MUL_VALUE);
+      const auto uniform = internal::UniformFromBits(real_tag, next);
       Store(uniform, real_tag, result.data() + i);
     }
 
@@ -486,7 +675,6 @@ public:
     alignas(HWY_ALIGNMENT) std::array<double, N> result;
     const ScalableTag<std::uint64_t> tag{};
     const ScalableTag<double> real_tag{};
-    const auto MUL_VALUE = Set(real_tag, internal::kMulConst);
 
     auto s0 = Load(tag, state_[{0}].data());
     auto s1 = Load(tag, state_[{1}].data());
@@ -495,9 +683,7 @@ public:
 
     for (std::uint64_t i = 0; i < N; i += Lanes(real_tag)) {
       const auto next = Update(s0, s1, s2, s3);
-      const auto bits = ShiftRight<expF64>(next);
-      const auto real = ConvertTo(real_tag, bits);
-      const auto uniform = Mul(real, MUL_VALUE);
+      const auto uniform = internal::UniformFromBits(real_tag, next);
       Store(uniform, real_tag, result.data() + i);
     }
 
@@ -510,10 +696,44 @@ public:
 
 #endif
 
+  /* Snapshot of the state vectors. RestoreState only accepts a snapshot of a
+   * VectorXoshiro of the same target, i.e. with as many streams. */
+  void SaveState(internal::StateWriter &out) const {
+    out.Put(internal::kXoshiroStateId);
+    out.Put(streams);
+    for (size_t j = 0UL; j < internal::Xoshiro::StateSize(); ++j) {
+      out.Put(state_[{j}].data(), streams);
+    }
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    std::uint64_t id = 0;
+    std::uint64_t n = 0;
+    if (!in.Get(id) || id != internal::kXoshiroStateId || !in.Get(n) ||
+        n != streams) {
+      return false;
+    }
+    for (size_t j = 0UL; j < internal::Xoshiro::StateSize(); ++j) {
+      if (!in.Get(state_[{j}].data(), streams)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
 private:
   StateType state_;
   std::uint64_t streams;
 
+  // Stores convert(next random vector) for n values, state in registers.
+  template <class D, class Convert>
+  HWY_INLINE void FillWith(const D d, TFromD<D> *HWY_RESTRICT data,
+                           const std::size_t n, const Convert &convert) {
+    Stream([&](auto &next) {
+      internal::StoreVectors(d, data, n, [&] { return convert(next()); });
+    });
+  }
+
   HWY_INLINE static auto Update(VU64 &s0, VU64 &s1, VU64 &s2,
                                 VU64 &s3) noexcept -> VU64 {
     const auto result = Add(RotateRight<41>(Add(s0, s3)), s0);
@@ -543,9 +763,449 @@ private:
   }
 };
 
-constexpr auto kCachedXoshiroSize = 1024;
+/* Counter-based Philox4x32-10 generator.
+ * The output is a pure function of (key, stream, counter): lane i of a call
+ * computes the Philox block of the 128-bit counter (counter + i, stream)
+ * under the 64-bit key. There is no state vector to load and store per call,
+ * any position of any stream can be computed independently (Block), and
+ * threads are separated by their stream index instead of by jumps.
+ * The object only tracks the next counter and the second half of the last
+ * block, so that it exposes the same interface as VectorXoshiro. */
+class VectorPhilox {
+private:
+  using VU32 = Vec<ScalableTag<std::uint32_t>>;
+  using VU64 = Vec<ScalableTag<std::uint64_t>>;
+  using VF32 = Vec<ScalableTag<float>>;
+#if HWY_HAVE_FLOAT64
+  using VF64 = Vec<ScalableTag<double>>;
+#endif
 
-template <std::uint64_t size = kCachedXoshiroSize> class CachedXoshiro {
+public:
+  explicit VectorPhilox(const std::uint64_t seed,
+                        const std::uint64_t threadNumber = 0)
+      : key_{seed}, stream_{threadNumber},
+        stash_{AllocateAligned<std::uint64_t>(
+            Lanes(ScalableTag<std::uint64_t>{}))} {
+#if PRISM_RNG_DEBUG
+    fprintf(stderr,
+            "[PRISM VectorPhilox] VectorPhilox initialized at %p: key %lu, "
+            "stream %lu\n",
+            this, key_, stream_);
+#endif
+  }
+
+  /* Philox4x32-10 blocks of the counters (counter + i, stream) for each lane
+   * i. The four 32-bit output words w0..w3 of each block are returned as
+   * lo = w0 | w1 << 32 and hi = w2 | w3 << 32.
+   * The 32-bit words are kept in 64-bit lanes so that the 32x32->64 products
+   * are plain 64-bit multiplications on every target. */
+  static HWY_INLINE void Block(const std::uint64_t key,
+                               const std::uint64_t stream,
+                               const std::uint64_t counter, VU64 &lo,
+                               VU64 &hi) noexcept {
+    const ScalableTag<std::uint64_t> tag{};
+    const auto mask = Set(tag, UINT64_C(0xFFFFFFFF));
+    const auto m0 = Set(tag, internal::kPhiloxM0);
+    const auto m1 = Set(tag, internal::kPhiloxM1);
+    const auto ctr = Add(Set(tag, counter), Iota(tag, 0));
+    auto c0 = And(ctr, mask);
+    auto c1 = ShiftRight<32>(ctr);
+    auto c2 = Set(tag, stream & UINT64_C(0xFFFFFFFF));
+    auto c3 = Set(tag, stream >> 32);
+    std::uint32_t k0 = static_cast<std::uint32_t>(key);
+    std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+
+    for (int round = 0; round < internal::kPhiloxRounds; ++round) {
+      const auto p0 = Mul(c0, m0);
+      const auto p1 = Mul(c2, m1);
+      c0 = Xor(Xor(ShiftRight<32>(p1), c1), Set(tag, std::uint64_t{k0}));
+      c1 = And(p1, mask);
+      c2 = Xor(Xor(ShiftRight<32>(p0), c3), Set(tag, std::uint64_t{k1}));
+      c3 = And(p0, mask);
+      k0 += internal::kPhiloxW0;
+      k1 += internal::kPhiloxW1;
+    }
+
+    lo = Or(c0, ShiftLeft<32>(c1));
+    hi = Or(c2, ShiftLeft<32>(c3));
+  }
+
+  HWY_INLINE auto operator()(std::uint32_t /*unused*/) noexcept -> VU32 {
+    return BitCast(ScalableTag<std::uint32_t>{}, Next());
+  }
+
+  HWY_INLINE auto operator()(std::uint64_t /*unused*/) noexcept -> VU64 {
+    return Next();
+  }
+
+  auto operator()(std::uint32_t /*unused*/,
+                  const std::size_t n) -> AlignedVector<std::uint32_t> {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    AlignedVector<std::uint32_t> result(2 * n);
+    for (std::size_t i = 0; i < n; i += Lanes(u32_tag)) {
+      Store(BitCast(u32_tag, Next()), u32_tag, result.data() + i);
+    }
+    return result;
+  }
+
+  auto operator()(std::uint64_t /*unused*/,
+                  const std::size_t n) -> AlignedVector<std::uint64_t> {
+    const ScalableTag<std::uint64_t> tag{};
+    AlignedVector<std::uint64_t> result(n);
+    for (std::size_t i = 0; i < n; i += Lanes(tag)) {
+      Store(Next(), tag, result.data() + i);
+    }
+    return result;
+  }
+
+  template <std::uint64_t N>
+  auto operator()(std::uint64_t /*unused*/) noexcept
+      -> std::array<std::uint64_t, N> {
+    alignas(HWY_ALIGNMENT) std::array<std::uint64_t, N> result;
+    fill<N>(result.data());
+    return result;
+  }
+
+  template <std::uint64_t N> void fill(std::uint64_t *HWY_RESTRICT data) {
+    fill(data, N);
+  }
+
+  // Same interface as VectorXoshiro::Stream; next() is Next().
+  template <class Body> HWY_INLINE void Stream(const Body &body) {
+    auto next = [this] { return Next(); };
+    body(next);
+  }
+
+  // Caller-buffer variants, as for VectorXoshiro: any n, any alignment.
+  void fill(std::uint64_t *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<std::uint64_t>{}, data, n,
+                           [this] { return Next(); });
+  }
+
+  void fill(std::uint32_t *HWY_RESTRICT data, const std::size_t n) {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    internal::StoreVectors(u32_tag, data, n, [this, u32_tag] {
+      return BitCast(u32_tag, Next());
+    });
+  }
+
+  void FillUniform(float *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<float>{}, data, n,
+                           [this] { return Uniform(float{}); });
+  }
+
+  template <std::uint64_t N> void FillUniform(float *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+
+  HWY_INLINE auto Uniform(float /*unused*/) noexcept -> VF32 {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    const ScalableTag<float> real_tag{};
+    return internal::UniformFromBits(real_tag, BitCast(u32_tag, Next()));
+  }
+
+#if HWY_HAVE_FLOAT64
+  void FillUniform(double *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<double>{}, data, n,
+                           [this] { return Uniform(double{}); });
+  }
+
+  template <std::uint64_t N> void FillUniform(double *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+
+  HWY_INLINE auto Uniform(double /*unused*/) noexcept -> VF64 {
+    const ScalableTag<double> real_tag{};
+    return internal::UniformFromBits(real_tag, Next());
+  }
+#endif
+
+  [[nodiscard]] auto StateSize() const noexcept -> std::uint64_t { return 3; }
+
+  [[nodiscard]] auto GetKey() const noexcept -> std::uint64_t { return key_; }
+  [[nodiscard]] auto GetStream() const noexcept -> std::uint64_t {
+    return stream_;
+  }
+  [[nodiscard]] auto GetCounter() const noexcept -> std::uint64_t {
+    return counter_;
+  }
+
+  // (key, stream, counter) and the pending second half of the last block.
+  void SaveState(internal::StateWriter &out) const {
+    const std::size_t lanes = Lanes(ScalableTag<std::uint64_t>{});
+    out.Put(internal::kPhiloxStateId);
+    out.Put(key_);
+    out.Put(stream_);
+    out.Put(counter_);
+    out.Put(has_stash_);
+    out.Put(stash_.get(), lanes);
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    const std::size_t lanes = Lanes(ScalableTag<std::uint64_t>{});
+    std::uint64_t id = 0;
+    return in.Get(id) && id == internal::kPhiloxStateId && in.Get(key_) &&
+           in.Get(stream_) && in.Get(counter_) && in.Get(has_stash_) &&
+           in.Get(stash_.get(), lanes);
+  }
+
+private:
+  std::uint64_t key_;
+  std::uint64_t stream_;
+  std::uint64_t counter_{0};
+  AlignedFreeUniquePtr<std::uint64_t[]> stash_;
+  bool has_stash_{false};
+
+  // Each block yields two vectors: return the first, keep the second one for
+  // the next call.
+  HWY_INLINE auto Next() noexcept -> VU64 {
+    const ScalableTag<std::uint64_t> tag{};
+    if (has_stash_) {
+      has_stash_ = false;
+      return Load(tag, stash_.get());
+    }
+    auto lo = Zero(tag);
+    auto hi = Zero(tag);
+    Block(key_, stream_, counter_, lo, hi);
+    counter_ += Lanes(tag);
+    Store(hi, tag, stash_.get());
+    has_stash_ = true;
+    return lo;
+  }
+};
+
+#if HWY_TARGET != HWY_SCALAR
+/* Counter-based vector engine built on AES rounds (ARS-7, Salmon et al.,
+ * "Parallel random numbers: as easy as 1, 2, 3", SC'11).
+ * Each 128-bit block i of a vector encrypts the counter (counter + i, stream)
+ * with seven AES rounds. The round keys follow a Weyl sequence from the key
+ * (seed, 0) instead of the AES key schedule. One call yields 128 random bits
+ * per block and the blocks do not depend on each other. AESRound maps to
+ * AES-NI / ARMv8 AES where available and to Highway's software fallback
+ * elsewhere. Not available on HWY_SCALAR, which has no 128-bit vectors. */
+class VectorAES {
+private:
+  using VU32 = Vec<ScalableTag<std::uint32_t>>;
+  using VU64 = Vec<ScalableTag<std::uint64_t>>;
+  using VF32 = Vec<ScalableTag<float>>;
+#if HWY_HAVE_FLOAT64
+  using VF64 = Vec<ScalableTag<double>>;
+#endif
+  using RoundKeys = std::array<std::uint64_t, 2 * (internal::kArsRounds + 1)>;
+
+public:
+  explicit VectorAES(const std::uint64_t seed,
+                     const std::uint64_t threadNumber = 0)
+      : key_{seed}, stream_{threadNumber}, round_keys_{GetRoundKeys(seed)} {
+#if PRISM_RNG_DEBUG
+    fprintf(stderr,
+            "[PRISM VectorAES] VectorAES initialized at %p: key %lu, "
+            "stream %lu\n",
+            this, key_, stream_);
+#endif
+  }
+
+  /* ARS-7 blocks of the counters (counter + i, stream) for each 128-bit block
+   * i of the vector. Block i is returned in 64-bit lanes 2i and 2i + 1. */
+  static HWY_INLINE auto Block(const std::uint64_t key,
+                               const std::uint64_t stream,
+                               const std::uint64_t counter) noexcept -> VU64 {
+    alignas(16) const RoundKeys round_keys = GetRoundKeys(key);
+    return Encrypt(round_keys.data(), stream, counter);
+  }
+
+  HWY_INLINE auto operator()(std::uint32_t /*unused*/) noexcept -> VU32 {
+    return BitCast(ScalableTag<std::uint32_t>{}, Next());
+  }
+
+  HWY_INLINE auto operator()(std::uint64_t /*unused*/) noexcept -> VU64 {
+    return Next();
+  }
+
+  auto operator()(std::uint32_t /*unused*/,
+                  const std::size_t n) -> AlignedVector<std::uint32_t> {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    AlignedVector<std::uint32_t> result(2 * n);
+    for (std::size_t i = 0; i < n; i += Lanes(u32_tag)) {
+      Store(BitCast(u32_tag, Next()), u32_tag, result.data() + i);
+    }
+    return result;
+  }
+
+  auto operator()(std::uint64_t /*unused*/,
+                  const std::size_t n) -> AlignedVector<std::uint64_t> {
+    const ScalableTag<std::uint64_t> tag{};
+    AlignedVector<std::uint64_t> result(n);
+    for (std::size_t i = 0; i < n; i += Lanes(tag)) {
+      Store(Next(), tag, result.data() + i);
+    }
+    return result;
+  }
+
+  template <std::uint64_t N>
+  auto operator()(std::uint64_t /*unused*/) noexcept
+      -> std::array<std::uint64_t, N> {
+    alignas(HWY_ALIGNMENT) std::array<std::uint64_t, N> result;
+    fill<N>(result.data());
+    return result;
+  }
+
+  template <std::uint64_t N> void fill(std::uint64_t *HWY_RESTRICT data) {
+    fill(data, N);
+  }
+
+  // Same interface as VectorXoshiro::Stream; next() is Next().
+  template <class Body> HWY_INLINE void Stream(const Body &body) {
+    auto next = [this] { return Next(); };
+    body(next);
+  }
+
+  // Caller-buffer variants, as for VectorXoshiro: any n, any alignment.
+  void fill(std::uint64_t *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<std::uint64_t>{}, data, n,
+                           [this] { return Next(); });
+  }
+
+  void fill(std::uint32_t *HWY_RESTRICT data, const std::size_t n) {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    internal::StoreVectors(u32_tag, data, n, [this, u32_tag] {
+      return BitCast(u32_tag, Next());
+    });
+  }
+
+  void FillUniform(float *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<float>{}, data, n,
+                           [this] { return Uniform(float{}); });
+  }
+
+  template <std::uint64_t N> void FillUniform(float *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+
+  HWY_INLINE auto Uniform(float /*unused*/) noexcept -> VF32 {
+    const ScalableTag<std::uint32_t> u32_tag{};
+    const ScalableTag<float> real_tag{};
+    return internal::UniformFromBits(real_tag, BitCast(u32_tag, Next()));
+  }
+
+#if HWY_HAVE_FLOAT64
+  void FillUniform(double *HWY_RESTRICT data, const std::size_t n) {
+    internal::StoreVectors(ScalableTag<double>{}, data, n,
+                           [this] { return Uniform(double{}); });
+  }
+
+  template <std::uint64_t N> void FillUniform(double *HWY_RESTRICT data) {
+    FillUniform(data, N);
+  }
+
+  HWY_INLINE auto Uniform(double /*unused*/) noexcept -> VF64 {
+    const ScalableTag<double> real_tag{};
+    return internal::UniformFromBits(real_tag, Next());
+  }
+#endif
+
+  [[nodiscard]] auto StateSize() const noexcept -> std::uint64_t { return 3; }
+
+  [[nodiscard]] auto GetKey() const noexcept -> std::uint64_t { return key_; }
+  [[nodiscard]] auto GetStream() const noexcept -> std::uint64_t {
+    return stream_;
+  }
+  [[nodiscard]] auto GetCounter() const noexcept -> std::uint64_t {
+    return counter_;
+  }
+
+  // The round keys are derived from the key again on restore.
+  void SaveState(internal::StateWriter &out) const {
+    out.Put(internal::kAESStateId);
+    out.Put(key_);
+    out.Put(stream_);
+    out.Put(counter_);
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    std::uint64_t id = 0;
+    if (!in.Get(id) || id != internal::kAESStateId || !in.Get(key_) ||
+        !in.Get(stream_) || !in.Get(counter_)) {
+      return false;
+    }
+    round_keys_ = GetRoundKeys(key_);
+    return true;
+  }
+
+private:
+  std::uint64_t key_;
+  std::uint64_t stream_;
+  std::uint64_t counter_{0};
+  alignas(16) RoundKeys round_keys_;
+
+  // Round key r is {key + r * kArsW0, r * kArsW1} (64-bit wrapping adds).
+  static auto GetRoundKeys(const std::uint64_t key) noexcept -> RoundKeys {
+    RoundKeys round_keys{};
+    std::uint64_t k0 = key;
+    std::uint64_t k1 = 0;
+    for (int round = 0; round <= internal::kArsRounds; ++round) {
+      round_keys[2 * round] = k0;
+      round_keys[2 * round + 1] = k1;
+      k0 += internal::kArsW0;
+      k1 += internal::kArsW1;
+    }
+    return round_keys;
+  }
+
+  // round_keys is read with LoadDup128, an aligned load: 16-byte aligned.
+  static HWY_INLINE auto Encrypt(const std::uint64_t *HWY_RESTRICT round_keys,
+                                 const std::uint64_t stream,
+                                 const std::uint64_t counter) noexcept
+      -> VU64 {
+    const ScalableTag<std::uint64_t> tag{};
+    const Repartition<std::uint8_t, decltype(tag)> tag8{};
+    // Lanes 2i and 2i + 1 hold the low and high halves of block i.
+    const auto block = ShiftRight<1>(Iota(tag, 0));
+    const auto ctr =
+        InterleaveLower(tag, Add(Set(tag, counter), block), Set(tag, stream));
+    auto state = BitCast(tag8, Xor(ctr, LoadDup128(tag, round_keys)));
+    for (int round = 1; round < internal::kArsRounds; ++round) {
+      const auto round_key = LoadDup128(tag, round_keys + 2 * round);
+      state = AESRound(state, BitCast(tag8, round_key));
+    }
+    const auto last_key =
+        LoadDup128(tag, round_keys + 2 * internal::kArsRounds);
+    return BitCast(tag, AESLastRound(state, BitCast(tag8, last_key)));
+  }
+
+  HWY_INLINE auto Next() noexcept -> VU64 {
+    const ScalableTag<std::uint64_t> tag{};
+    const auto result = Encrypt(round_keys_.data(), stream_, counter_);
+    counter_ += Lanes(tag) / 2;
+    return result;
+  }
+};
+#endif // HWY_TARGET != HWY_SCALAR
+
+constexpr auto kCachedXoshiroSize = 1024;
+// Size of the first fill. Must be a multiple of the widest vector (32 words on
+// 2048-bit SVE).
+constexpr std::uint64_t kCachedXoshiroInitialSize = 256;
+// Words regenerated at once by the incremental refill. A power of 2, multiple
+// of the widest vector.
+constexpr std::uint64_t kCachedXoshiroSliceSize = 64;
+
+/* Cache of random 64-bit words refilled from a vector generator.
+ * `size` is the default capacity; the capacity can also be given at run time.
+ * The cache starts at kCachedXoshiroInitialSize words (or the capacity if
+ * smaller) and doubles at each wrap-around until it reaches the capacity, so
+ * a thread that draws few numbers keeps a small footprint.
+ * The cache is read as a ring and refilled incrementally: each time the read
+ * index crosses a slice boundary, the slice just consumed is regenerated with
+ * the next words of the generator. Refill cost is then spread evenly (one
+ * slice every `slice` draws) instead of one draw in `size` paying for the
+ * whole cache. A slice of 0 refills the whole cache at once when it is
+ * exhausted. The words drawn depend neither on the cache size nor on the
+ * slice size. The first fill is deferred to the first draw, so that a cache
+ * whose generator is only used through Engine() never consumes words. */
+template <std::uint64_t size = kCachedXoshiroSize,
+          class Generator = VectorXoshiro>
+class CachedXoshiro {
 public:
   using result_type = std::uint64_t;
 
@@ -557,47 +1217,296 @@ public:
     return (std::numeric_limits<result_type>::max)();
   }
 
+  // capacity must be a power of 2, at least kCachedXoshiroInitialSize.
+  // slice must be 0 or a power of 2 in [32, kCachedXoshiroInitialSize].
   explicit CachedXoshiro(const result_type seed,
-                         const result_type threadNumber = 0)
-      : generator_{seed, threadNumber},
-        cache_{generator_.operator()<size>(result_type{})} {
-
+                         const result_type threadNumber = 0,
+                         const std::size_t capacity = size,
+                         const std::size_t slice = kCachedXoshiroSliceSize)
+      : generator_{seed, threadNumber}, capacity_{capacity},
+        size_{HWY_MIN(capacity, kCachedXoshiroInitialSize)}, slice_{slice},
+        cache_{AllocateAligned<result_type>(size_)} {
+    HWY_DASSERT((capacity & (capacity - 1)) == 0 &&
+                capacity >= kCachedXoshiroInitialSize);
+    HWY_DASSERT((slice & (slice - 1)) == 0 &&
+                slice <= kCachedXoshiroInitialSize);
 #if PRISM_RNG_DEBUG
     fprintf(stderr,
             "[PRISM CachedXoshiro] CachedXoshiro initialized at %p: %lu "
-            "streams, %lu states\n",
-            this, size, generator_.StateSize());
+            "capacity, %lu slice, %lu states\n",
+            this, capacity_, slice_, generator_.StateSize());
 #endif
   }
 
   auto operator()() noexcept -> result_type {
-    if (HWY_UNLIKELY(index_ == size)) {
-      generator_.fill<size>(cache_.data());
-      index_ = 0;
-#if PRISM_RNG_DEBUG
-      static int call_count = 0;
-      fprintf(stderr,
-              "[PRISM CachedXoshiro] [%d] CachedXoshiro cache exhausted, "
-              "generating new cache at %p\n",
-              ++call_count, cache_.data());
-#endif
+    if (HWY_UNLIKELY(index_ == next_refill_)) {
+      Advance();
     }
     return cache_[index_++];
   }
 
+  /* The generator the cache is refilled from. Words drawn from it directly
+   * are simply never cached, so the vector API can share it with the scalar
+   * one: both see disjoint parts of one stream. */
+  auto Engine() noexcept -> Generator & { return generator_; }
+
+  // Current number of cached words and the size it can grow to.
+  [[nodiscard]] auto Size() const noexcept -> std::size_t { return size_; }
+  [[nodiscard]] auto Capacity() const noexcept -> std::size_t {
+    return capacity_;
+  }
+
   auto Uniform() noexcept -> double {
-    return static_cast<double>(operator()() >> expF64) * internal::kMulConst;
+    return internal::UniformFromBits<double>(operator()());
+  }
+
+  /* binary32 uniform from 32 random bits: each cached word serves two draws,
+   * low half first. */
+  auto Uniform(float /*unused*/) noexcept -> float {
+    if (has_half_) {
+      has_half_ = false;
+      return internal::UniformFromBits<float>(half_);
+    }
+    const result_type word = operator()();
+    half_ = static_cast<std::uint32_t>(word >> 32);
+    has_half_ = true;
+    return internal::UniformFromBits<float>(static_cast<std::uint32_t>(word));
+  }
+
+  /* Snapshot of the generator, the cached words and the read position. The
+   * restored object draws the exact words this one would have drawn next,
+   * whatever its own capacity was. */
+  void SaveState(internal::StateWriter &out) const {
+    generator_.SaveState(out);
+    out.Put(capacity_);
+    out.Put(size_);
+    out.Put(slice_);
+    out.Put(index_);
+    out.Put(next_refill_);
+    out.Put(half_);
+    out.Put(has_half_);
+    out.Put(cache_.get(), size_);
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    std::size_t capacity = 0;
+    std::size_t cached = 0;
+    std::size_t slice = 0;
+    std::size_t index = 0;
+    std::size_t next_refill = 0;
+    if (!generator_.RestoreState(in) || !in.Get(capacity) ||
+        !in.Get(cached) || !in.Get(slice) || !in.Get(index) ||
+        !in.Get(next_refill) || !in.Get(half_) || !in.Get(has_half_)) {
+      return false;
+    }
+    const auto is_pow2 = [](std::size_t x) { return (x & (x - 1)) == 0; };
+    if (!is_pow2(capacity) || capacity < kCachedXoshiroInitialSize ||
+        !is_pow2(cached) || cached > capacity ||
+        cached < kCachedXoshiroInitialSize || !is_pow2(slice) ||
+        slice > kCachedXoshiroInitialSize || index > next_refill ||
+        next_refill > cached) {
+      return false;
+    }
+    auto cache = AllocateAligned<result_type>(cached);
+    if (!in.Get(cache.get(), cached)) {
+      return false;
+    }
+    capacity_ = capacity;
+    size_ = cached;
+    slice_ = slice;
+    index_ = index;
+    next_refill_ = next_refill;
+    cache_ = std::move(cache);
+    return true;
   }
 
 private:
-  VectorXoshiro generator_;
-  alignas(HWY_ALIGNMENT) std::array<result_type, size> cache_;
+  Generator generator_;
+  std::size_t capacity_;
+  std::size_t size_;
+  std::size_t slice_;
+  AlignedFreeUniquePtr<result_type[]> cache_;
   std::size_t index_{};
+  std::size_t next_refill_{};
+  std::uint32_t half_{};
+  bool has_half_{false};
+
+  [[nodiscard]] auto Slice() const noexcept -> std::size_t {
+    return slice_ == 0 ? size_ : slice_;
+  }
+
+  // index_ sits on a slice boundary: regenerate the slice just consumed.
+  // Slices are regenerated in reading order, so once the ring wraps around the
+  // words read are the generator output that follows the previous lap.
+  HWY_NOINLINE void Advance() {
+    if (HWY_UNLIKELY(next_refill_ == 0)) {
+      // First draw: fill the initial cache.
+      generator_.fill(cache_.get(), size_);
+      next_refill_ = Slice();
+      return;
+    }
+    const std::size_t slice = Slice();
+    if (index_ < size_) {
+      generator_.fill(cache_.get() + index_ - slice, slice);
+      next_refill_ = index_ + slice;
+      return;
+    }
+    if (size_ < capacity_) {
+      Grow();
+    } else {
+      generator_.fill(cache_.get() + size_ - slice, slice);
+    }
+    index_ = 0;
+    next_refill_ = Slice();
+#if PRISM_RNG_DEBUG
+    static int call_count = 0;
+    fprintf(stderr,
+            "[PRISM CachedXoshiro] [%d] CachedXoshiro wrapped around, %lu "
+            "words at %p\n",
+            ++call_count, size_, cache_.get());
+#endif
+  }
+
+  // At wrap-around: all slices but the last one already hold the next words.
+  // Keep them at the front of the larger cache and generate the rest.
+  void Grow() {
+    const std::size_t pending = size_ - Slice();
+    const std::size_t new_size = HWY_MIN(2 * size_, capacity_);
+    auto grown = AllocateAligned<result_type>(new_size);
+    std::memcpy(grown.get(), cache_.get(), pending * sizeof(result_type));
+    generator_.fill(grown.get() + pending, new_size - pending);
+    cache_ = std::move(grown);
+    size_ = new_size;
+  }
 
   static_assert((size & (size - 1)) == 0 && size != 0,
                 "only power of 2 are supported");
 };
 
+constexpr auto kUniformRingSize = 1024;
+
+/* Per-thread ring of pre-generated uniform vectors.
+ * The SR round() consumes one uniform vector per call. Generating it on
+ * demand costs a state load/update/store plus the bits to float
+ * conversion on the critical path of every operation. The ring is refilled
+ * in bulk from the generator (state kept in registers for the whole refill)
+ * and each call then reduces to a single aligned load.
+ * The values are the exact sequence that repeated calls to
+ * VectorXoshiro::Uniform would have produced. The ring does not own the
+ * generator so that the vector API draws from a single stream. */
+template <std::uint64_t size = kUniformRingSize> class UniformRing {
+public:
+  template <class Generator>
+  HWY_INLINE auto Uniform(Generator &generator,
+                          float /*unused*/) noexcept -> Vec<ScalableTag<float>> {
+    const ScalableTag<float> tag{};
+    if (HWY_UNLIKELY(index_f32_ == size)) {
+      generator.template FillUniform<size>(f32_.data());
+      index_f32_ = 0;
+    }
+    const auto result = Load(tag, f32_.data() + index_f32_);
+    index_f32_ += Lanes(tag);
+    return result;
+  }
+
+#if HWY_HAVE_FLOAT64
+  template <class Generator>
+  HWY_INLINE auto Uniform(Generator &generator, double /*unused*/) noexcept
+      -> Vec<ScalableTag<double>> {
+    const ScalableTag<double> tag{};
+    if (HWY_UNLIKELY(index_f64_ == size)) {
+      generator.template FillUniform<size>(f64_.data());
+      index_f64_ = 0;
+    }
+    const auto result = Load(tag, f64_.data() + index_f64_);
+    index_f64_ += Lanes(tag);
+    return result;
+  }
+#endif
+
+  // Drop the pre-generated values, e.g. after the generator was reseeded.
+  void Reset() noexcept {
+    index_f32_ = size;
+    index_f64_ = size;
+  }
+
+  void SaveState(internal::StateWriter &out) const {
+    out.Put(index_f32_);
+    out.Put(f32_.data(), size);
+    out.Put(index_f64_);
+    out.Put(f64_.data(), size);
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    return in.Get(index_f32_) && index_f32_ <= size &&
+           in.Get(f32_.data(), size) && in.Get(index_f64_) &&
+           index_f64_ <= size && in.Get(f64_.data(), size);
+  }
+
+private:
+  alignas(HWY_ALIGNMENT) std::array<float, size> f32_;
+  alignas(HWY_ALIGNMENT) std::array<double, size> f64_;
+  std::size_t index_f32_{size};
+  std::size_t index_f64_{size};
+
+  static_assert((size & (size - 1)) == 0 && size != 0,
+                "only power of 2 are supported");
+};
+
+/* Per-lane reservoir of random bits handing out r-bit chunks.
+ * One vector of random words feeds width / r consecutive calls. Lane i only
+ * consumes bits of its own word and successive calls read disjoint bit
+ * fields, so lanes and calls stay independent. With r = 1 the pool hands out
+ * whole bit-planes, as used by UD rounding. */
+template <typename T> class ChunkPool {
+public:
+  ChunkPool() : words_{AllocateAligned<T>(Lanes(ScalableTag<T>{}))} {}
+
+  // r must be in [1, width).
+  template <class Generator>
+  HWY_INLINE auto Next(Generator &generator,
+                       const int bits) noexcept -> Vec<ScalableTag<T>> {
+    const ScalableTag<T> tag{};
+    if (HWY_UNLIKELY(left_ < bits)) {
+      Store(generator(T{}), tag, words_.get());
+      left_ = kWidth;
+    }
+    left_ -= bits;
+    const auto words = Load(tag, words_.get());
+    const auto mask = Set(tag, static_cast<T>((T{1} << bits) - 1));
+    return And(ShiftRightSame(words, left_), mask);
+  }
+
+  // Drop the remaining bits, e.g. after the generator was reseeded.
+  void Reset() noexcept { left_ = 0; }
+
+  void SaveState(internal::StateWriter &out) const {
+    out.Put(left_);
+    out.Put(words_.get(), Lanes(ScalableTag<T>{}));
+  }
+
+  auto RestoreState(internal::StateReader &in) -> bool {
+    return in.Get(left_) && left_ >= 0 && left_ <= kWidth &&
+           in.Get(words_.get(), Lanes(ScalableTag<T>{}));
+  }
+
+private:
+  static constexpr int kWidth = sizeof(T) * 8;
+  AlignedFreeUniquePtr<T[]> words_;
+  int left_{0};
+};
+
+/* Vector engine behind the PRISM random API, selected at build time.
+ * Define PRISM_RNG_PHILOX to use the counter-based Philox4x32-10 engine, or
+ * PRISM_RNG_AES to use the AES-round engine (xoshiro256++ on HWY_SCALAR). */
+#if defined(PRISM_RNG_PHILOX)
+using VectorEngine = VectorPhilox;
+#elif defined(PRISM_RNG_AES) && HWY_TARGET != HWY_SCALAR
+using VectorEngine = VectorAES;
+#else
+using VectorEngine = VectorXoshiro;
+#endif
+
 } // namespace HWY_NAMESPACE
 } // namespace hwy
 
@@ -5,9 +5,11 @@
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <unistd.h>
 
 #if defined(PRISM_SR_SCALAR_INL_H) == defined(HWY_TARGET_TOGGLE)
@@ -80,10 +82,13 @@ template <typename T>
 inline auto round(const T sigma, const T tau,
                   const prism::sr::ConfigSnapshot &config) -> T {
   const int32_t t = config.virtual_precision;
-  using prism::utils::get_exponent;
-  using prism::utils::get_predecessor_abs;
   using prism::utils::IEEE754;
   using prism::utils::pow2;
+  using I = typename IEEE754<T>::I;
+
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return prism::sr::round_nearest(sigma, tau, t);
+  }
 
   debug_start();
 
@@ -108,29 +113,44 @@ inline auto round(const T sigma, const T tau,
   const bool sign_delta = (rho == 0) ? sign_tau : sign_rho;
   const T sign_dir = sign_delta ? T{-1} : T{1};
 
-  // If the distance pushes us in the opposite direction of our value,
-  // we are moving towards zero, so the predecessor might drop an exponent.
-  const int32_t eta = (sign_delta != sign_trunc)
-                          ? get_exponent(get_predecessor_abs(trunc))
-                          : get_exponent(trunc);
-
-  // Compute ulp at precision t
-  const T ulp_t = sign_dir * pow2<T>(eta - (t - 1));
+  // eta is the exponent of the binade of ulp_t, read from the bits of trunc:
+  // the exponent of trunc (zero and subnormals read as min_exponent), minus
+  // one if the distance pushes us towards zero from a normal power of two,
+  // whose predecessor is in the binade below.
+  constexpr I mantissa = IEEE754<T>::mantissa;
+  constexpr I fraction_mask = (I{1} << mantissa) - 1;
+  const I bits = prism::utils::binaryN<T>{.f = trunc}.i &
+                 std::numeric_limits<I>::max();
+  const I biased = std::max(bits >> mantissa, I{1});
+  const bool is_pow2 = ((bits & fraction_mask) == 0) && (biased > 1);
+  const I eta_biased =
+      biased - static_cast<I>((sign_delta != sign_trunc) && is_pow2);
+
+  // Compute ulp at precision t: 2^eta * 2^-(t-1), exact even when the result
+  // is subnormal.
+  const T pow2_eta = prism::utils::binaryN<T>{.i = eta_biased << mantissa}.f;
+  const T ulp_t = sign_dir * (pow2_eta * pow2<T>(1 - t));
 
   // For ulp_t subnormals we scale the variables by 2^64 to lift them into the
   // normal range to preserve full random precision when generating pi.
   // (scaling is exact)
-  constexpr int32_t min_exp = IEEE754<T>::min_exponent;
-  const T scale = (eta - (t - 1) <= min_exp) ? pow2<T>(64) : T{1};
+  // eta - (t - 1) <= min_exponent reads eta_biased <= t on the biased scale.
+  const T scale = (eta_biased <= t) ? pow2<T>(64) : T{1};
   const T sc_rho = rho * scale;
   const T sc_tau = tau * scale;
   const T sc_ulp = ulp_t * scale;
 
   // We sample pi in Uniform(0, sc_ulp)
-  // In SR mode, z is a random sample from Uniform(0, 1).
-  // In RN mode, z = 0.5 gives untied round-to-nearest (ties away from zero).
-  const T z = (config.rounding_mode == prism::sr::PRISM_RN) ? T{0.5}
-                                                            : rng::uniform(T{});
+  // z is a random sample from Uniform(0, 1), drawn from config.random_bits
+  // bits when a random-bit budget is set. The sampling scheme then maps z to
+  // the sample of this run.
+  T z;
+  if (config.random_bits != prism::sr::PRISM_RANDOM_BITS_FULL) {
+    z = prism::sr::apply_sampling(rng::uniform(T{}, config.random_bits),
+                                  config);
+  } else {
+    z = prism::sr::apply_sampling(rng::uniform(T{}), config);
+  }
   const T pi = sc_ulp * z;
 
   // We want to check if P < |x - trunc| where P = abs(pi).
@@ -145,7 +165,8 @@ inline auto round(const T sigma, const T tau,
   debug_print("sigma     = %+.13a\n", sigma);
   debug_print("trunc     = %+.13a\n", trunc);
   debug_print("rho       = %+.13a\n", rho);
-  debug_print("eta       = %d\n", eta);
+  debug_print("eta       = %d\n",
+              static_cast<int32_t>(eta_biased - IEEE754<T>::bias));
   debug_print("ulp_t     = %+.13a\n", ulp_t);
   debug_print("D         = %+.13a\n", D);
   debug_end();
@@ -153,8 +174,76 @@ inline auto round(const T sigma, const T tau,
   return trunc + rnd;
 }
 
+/* Round-to-nearest kernels (PRISM_RN), selected once per operation from the
+ * configuration snapshot. At hardware precision they return the native
+ * result, ties to even; at reduced precision they round the error-free pair
+ * with round_nearest, ties away from zero. */
+namespace rn {
+
+template <typename T> inline auto is_native(const int32_t t) -> bool {
+  return t >= prism::utils::IEEE754<T>::precision;
+}
+
+template <typename T>
+inline auto add(const T a, const T b, const int32_t t) -> T {
+  if (is_native<T>(t)) {
+    return a + b;
+  }
+  T sigma;
+  T tau;
+  twosum(a, b, sigma, tau);
+  return prism::sr::round_nearest(sigma, tau, t);
+}
+
+template <typename T>
+inline auto mul(const T a, const T b, const int32_t t) -> T {
+  if (is_native<T>(t)) {
+    return a * b;
+  }
+  T sigma;
+  T tau;
+  twoprodfma(a, b, sigma, tau);
+  return prism::sr::round_nearest(sigma, tau, t);
+}
+
+template <typename T>
+inline auto div(const T a, const T b, const int32_t t) -> T {
+  const T sigma = a / b;
+  if (is_native<T>(t)) {
+    return sigma;
+  }
+  const T tau = std::fma(-sigma, b, a) / b;
+  return prism::sr::round_nearest(sigma, tau, t);
+}
+
+template <typename T> inline auto sqrt(const T a, const int32_t t) -> T {
+  const T sigma = std::sqrt(a);
+  if (is_native<T>(t) or not std::isfinite(a) or a <= 0) {
+    return sigma;
+  }
+  const T tau = std::fma(-sigma, sigma, a) / (2 * sigma);
+  return prism::sr::round_nearest(sigma, tau, t);
+}
+
+template <typename T>
+inline auto fma(const T a, const T b, const T c, const int32_t t) -> T {
+  if (is_native<T>(t) or not std::isfinite(a) or not std::isfinite(b) or
+      not std::isfinite(c)) {
+    return std::fma(a, b, c);
+  }
+  T sigma;
+  T tau;
+  errfma(a, b, c, sigma, tau);
+  return prism::sr::round_nearest(sigma, tau, t);
+}
+
+} // namespace rn
+
 template <typename T> inline auto add(const T a, const T b) -> T {
   const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::add(a, b, config.virtual_precision);
+  }
   debug_start();
   if (not isnumber(a, b, config)) {
     debug_end();
@@ -173,6 +262,9 @@ template <typename T> inline auto sub(T a, T b) -> T { return add(a, -b); }
 
 template <typename T> inline auto mul(T a, T b) -> T {
   const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::mul(a, b, config.virtual_precision);
+  }
   debug_start();
   if (not isnumber(a, b, config)) {
     debug_end();
@@ -188,6 +280,9 @@ template <typename T> inline auto mul(T a, T b) -> T {
 
 template <typename T> inline auto div(const T a, const T b) -> T {
   const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::div(a, b, config.virtual_precision);
+  }
   debug_start();
   if (not isnumber(a, b, config)) {
     debug_end();
@@ -210,6 +305,9 @@ template <typename T> inline auto div(const T a, const T b) -> T {
 
 template <typename T> inline auto sqrt(const T a) -> T {
   const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::sqrt(a, config.virtual_precision);
+  }
   const T sigma = std::sqrt(a);
   if (not std::isfinite(a) or a <= 0) {
     return sigma;
@@ -219,39 +317,19 @@ template <typename T> inline auto sqrt(const T a) -> T {
   return round(sigma, tau, config);
 }
 
-/*
-"Exact and Approximated error of the FMA"
-Sylvie Boldo, Jean-Michel Muller
----
-Algorithm 5 (ErrFmaNearest):
-  r1 = ◦(ax + y)
-  (u1, u2) = Fast2Mult(a, x)
-  (α1, α2) = 2Sum(y, u2)
-  (β1, β2) = 2Sum(u1, α1)
-  γ = ◦(◦(β1 − r1) + β2)
-  r2 = ◦(γ + α2)
-*/
+// Error of the FMA with errfma (Boldo and Muller, see eft.h).
 template <typename T> inline auto fma(const T a, const T b, const T c) -> T {
   const auto config = prism::sr::get_config_snapshot<T>();
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::fma(a, b, c, config.virtual_precision);
+  }
   if (not std::isfinite(a) or not std::isfinite(b) or not std::isfinite(c)) {
     return std::fma(a, b, c);
   }
   debug_start();
-  T u1;
-  T u2;
-  T alpha1;
-  T alpha2;
-  T beta1;
-  T beta2;
-  T gamma;
   T r1;
   T r2;
-  r1 = std::fma(a, b, c);
-  twoprodfma(a, b, u1, u2);
-  twosum(c, u2, alpha1, alpha2);
-  twosum(u1, alpha1, beta1, beta2);
-  gamma = (beta1 - r1) + beta2;
-  r2 = gamma + alpha2;
+  errfma(a, b, c, r1, r2);
   const T res = round(r1, r2, config);
   debug_print("sr_fma(%+.13a, %+.13a, %+.13a) = %+.13a\n", a, b, c, res);
   debug_end();
@@ -467,19 +467,28 @@ HWY_INLINE auto pow2(const D d, const VI n) -> hn::VFromD<D> {
   return res_float;
 }
 
-template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+// Value of the kPrecision template parameter of truncate_mantissa, round and
+// the z forms of the operations when the virtual precision t is only known
+// at runtime. Any other value is t itself, as a compile-time constant: the
+// truncation mask and the ulp scale become immediates and, at hardware
+// precision, the truncation folds away.
+constexpr int32_t kRuntimePrecision = 0;
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
 HWY_INLINE auto truncate_mantissa(const D d, const V val,
                                   const int32_t t) -> V {
   constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  const int32_t precision = kPrecision == kRuntimePrecision ? t : kPrecision;
 
-  if (HWY_UNLIKELY((t - 1) >= mantissa))
+  if (HWY_UNLIKELY((precision - 1) >= mantissa))
     return val;
 
   using DU = hn::RebindToUnsigned<D>;
   const DU du{};
   using U = hn::TFromD<DU>;
 
-  const int32_t shift = mantissa - (t - 1);
+  const int32_t shift = mantissa - (precision - 1);
   const U mask_val = ~((static_cast<U>(1) << shift) - 1);
   const auto mask = hn::Set(du, mask_val);
 
@@ -488,6 +497,30 @@ HWY_INLINE auto truncate_mantissa(const D d, const V val,
   return hn::BitCast(d, masked_bits);
 }
 
+// Biased exponent of the binade of ulp_t, derived from the bits of trunc:
+// the exponent of trunc, with zero and subnormals read as min_exponent, minus
+// one when towards_zero is set and |trunc| is a normal power of two other
+// than 2^min_exponent (x then lies in the binade below). Same as
+// get_exponent(get_predecessor_abs(trunc)) or get_exponent(trunc) plus the
+// bias, without the floating-point round trip.
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>,
+          class DI = hn::RebindToSigned<D>>
+HWY_INLINE auto get_ulp_exponent_biased(const D d, const V trunc,
+                                        const hn::MFromD<DI> towards_zero)
+    -> hn::VFromD<DI> {
+  using I = hn::TFromD<DI>;
+  const DI di{};
+  constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  const auto one = hn::Set(di, I{1});
+  const auto bits = hn::BitCast(di, hn::Abs(trunc));
+  const auto biased = hn::Max(hn::ShiftRight<mantissa>(bits), one);
+  const auto fraction = hn::And(bits, hn::Set(di, (I{1} << mantissa) - 1));
+  const auto is_pow2 =
+      hn::And(hn::Eq(fraction, hn::Zero(di)), hn::Gt(biased, one));
+  // VecFromMask is -1 in the lanes that drop to the binade below.
+  return hn::Add(biased, hn::VecFromMask(di, hn::And(towards_zero, is_pow2)));
+}
+
 // Variable Precision Stochastic Rounding (Vector)
 //
 // Based on the algorithm in Fasi and Mikaitis: Algorithms for Stochastically
@@ -499,29 +532,39 @@ HWY_INLINE auto truncate_mantissa(const D d, const V val,
 // Given sigma + tau (an error-free representation of the exact result x),
 // returns SR_t(x): the stochastically rounded result at virtual precision t.
 //
+// z is the random sample from Uniform[0, 1) that sets the threshold; it is
+// taken as is, so z = 0.5 gives round-to-nearest (RN mode uses rn::round
+// instead, see round_lazy).
 // The result is returned directly.
 //
 // Proof of exact sign evaluation for D = (rho - pi) + tau available at:
 //
 //       https://github.com/user-attachments/files/29456845/vpsr.pdf
 //
-template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
-HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
+// kPrecision is t as a compile-time constant, or kRuntimePrecision to take
+// it from config.
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto round(const D d, const V sigma, const V tau, const V z,
                        const prism::sr::ConfigSnapshot &config) -> V {
   dbg::debug_msg("\n[sr_round] START");
   dbg::debug_vec(d, "[sr_round] σ", sigma);
   dbg::debug_vec(d, "[sr_round] τ", tau);
 
-  const int32_t t = config.virtual_precision;
+  const int32_t t = kPrecision == kRuntimePrecision ? config.virtual_precision
+                                                    : kPrecision;
   const auto zero = hn::Zero(d);
   const auto one = hn::Set(d, T{1});
   const auto neg_one = hn::Set(d, T{-1});
 
   // compute trunc_t(sigma), the truncated value at precision t
-  const auto trunc = truncate_mantissa(d, sigma, t);
+  // (a no-op at hardware precision when t is a compile-time constant)
+  const auto trunc = truncate_mantissa<kPrecision>(d, sigma, t);
 
   // rho is the distance from sigma to trunc
   // the computation is exact in IEEE-754
+  // It is kept at hardware precision, where it is 0 for finite sigma: the
+  // NaN it gives for infinite sigma keeps overflows from rounding to NaN.
   const auto rho = hn::Sub(sigma, trunc);
 
   // Early exit: x = sigma + tau is exactly representable in precision t
@@ -549,41 +592,17 @@ HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
   const DI di{};
   const auto sign_diff_int = hn::RebindMask(di, sign_diff);
 
-  const auto pred_trunc = get_predecessor_abs(d, trunc);
-
-  // Cache exponent calculations to avoid redundant computation
-  using VI = hn::VFromD<DI>;
-  thread_local static V last_trunc = hn::Zero(d);
-  thread_local static VI last_trunc_exp = hn::Zero(di);
-  thread_local static V last_pred_trunc = hn::Zero(d);
-  thread_local static VI last_pred_trunc_exp = hn::Zero(di);
-
-  VI trunc_exp, pred_trunc_exp;
+  // eta is the exponent of the binade of ulp_t, read from the bits of trunc
+  // (see get_ulp_exponent_biased).
+  const auto eta_biased = get_ulp_exponent_biased(d, trunc, sign_diff_int);
+  dbg::debug_vec(di, "[sr_round] η (biased)", eta_biased, false);
 
-  // Check if we can reuse cached trunc exponent
-  if (HWY_LIKELY(hn::AllTrue(d, hn::Eq(trunc, last_trunc)))) {
-    trunc_exp = last_trunc_exp;
-  } else {
-    trunc_exp = get_exponent(d, trunc);
-    last_trunc = trunc;
-    last_trunc_exp = trunc_exp;
-  }
-
-  // Check if we can reuse cached pred_trunc exponent
-  if (HWY_LIKELY(hn::AllTrue(d, hn::Eq(pred_trunc, last_pred_trunc)))) {
-    pred_trunc_exp = last_pred_trunc_exp;
-  } else {
-    pred_trunc_exp = get_exponent(d, pred_trunc);
-    last_pred_trunc = pred_trunc;
-    last_pred_trunc_exp = pred_trunc_exp;
-  }
-  const auto eta = hn::IfThenElse(sign_diff_int, pred_trunc_exp, trunc_exp);
-  dbg::debug_vec(di, "[sr_round] η", eta, false);
-
-  // Compute ulp at precision t
-  const auto t_v = hn::Set(di, (t - 1));
-  const auto exp = hn::Sub(eta, t_v);
-  const auto abs_ulp_t = pow2(d, exp);
+  // Compute ulp at precision t: 2^eta * 2^-(t-1), exact even when the
+  // result is subnormal.
+  constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  const auto pow2_eta = hn::BitCast(d, hn::ShiftLeft<mantissa>(eta_biased));
+  const auto abs_ulp_t =
+      hn::Mul(pow2_eta, hn::Set(d, prism::utils::pow2<T>(1 - t)));
 
   // ulp_t = sign_dir * abs_ulp_t
   const auto ulp_t = hn::Mul(sign_dir, abs_ulp_t);
@@ -592,9 +611,8 @@ HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
   // For ulp_t subnormals we scale the variables by 2^64 to lift them into the
   // normal range to preserve full random precision when generating pi.
   // (scaling is exact)
-  constexpr int32_t min_exp = prism::utils::IEEE754<T>::min_exponent;
-  const auto min_exp_v = hn::Set(di, min_exp);
-  const auto is_min_exp = hn::Le(hn::Sub(eta, t_v), min_exp_v);
+  // eta - (t - 1) <= min_exponent reads eta_biased <= t on the biased scale.
+  const auto is_min_exp = hn::Le(eta_biased, hn::Set(di, t));
   const auto scale = hn::IfThenElse(hn::RebindMask(d, is_min_exp),
                                     hn::Set(d, prism::utils::pow2<T>(64)), one);
   const auto sc_rho = hn::Mul(rho, scale);
@@ -602,15 +620,6 @@ HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
   const auto sc_ulp = hn::Mul(ulp_t, scale);
 
   // We sample pi in Uniform(0, sc_ulp)
-  // In SR mode, z is a random sample from Uniform(0, 1).
-  // In RN mode, z = 0.5 gives untied round-to-nearest (ties away from zero).
-  V z;
-  if (config.rounding_mode == prism::sr::PRISM_RN) {
-    z = hn::Set(d, T{0.5});
-  } else {
-    const auto z_rng = rng::uniform(T{});
-    z = hn::ResizeBitCast(d, z_rng);
-  }
   const auto pi = hn::Mul(sc_ulp, z);
 
   // We want to check if P < |x - trunc| where P = abs(pi).
@@ -635,6 +644,135 @@ HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
   return res;
 }
 
+// Vector counterpart of prism::sr::apply_sampling: maps the sample z drawn
+// from the random stream to the sample of this run, in [0, 1).
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_INLINE auto apply_sampling(const D d, const V z,
+                               const prism::sr::ConfigSnapshot &config) -> V {
+  if (HWY_LIKELY(config.sampling == prism::sr::PRISM_SAMPLING_MC)) {
+    return z;
+  }
+  constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  if (config.sampling == prism::sr::PRISM_SAMPLING_ANTITHETIC) {
+    constexpr T kLast = T{1} - T{1} / static_cast<T>(uint64_t{1} << mantissa);
+    return (config.run_shift >> 63) != 0 ? hn::Sub(hn::Set(d, kLast), z) : z;
+  }
+  const auto one = hn::Set(d, T{1});
+  const hn::RebindToUnsigned<D> du;
+  using U = hn::TFromD<decltype(du)>;
+  const auto shift =
+      hn::Set(du, static_cast<U>(config.run_shift >> (64 - mantissa)));
+  const auto bits = hn::Xor(hn::BitCast(du, hn::Add(one, z)), shift);
+  return hn::Sub(hn::BitCast(d, bits), one);
+}
+
+// z is a random sample from Uniform(0, 1), drawn from config.random_bits
+// bits per lane when a random-bit budget is set, and mapped by the sampling
+// scheme.
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_INLINE auto sample_z(const D d, const prism::sr::ConfigSnapshot &config)
+    -> V {
+  if (config.random_bits != prism::sr::PRISM_RANDOM_BITS_FULL) {
+    return apply_sampling(
+        d, hn::ResizeBitCast(d, rng::uniform(T{}, config.random_bits)),
+        config);
+  }
+  return apply_sampling(d, hn::ResizeBitCast(d, rng::uniform(T{})), config);
+}
+
+/* Round-to-nearest (PRISM_RN) at virtual precision t, ties away from zero,
+ * as prism::sr::round_nearest: x = sigma + tau is rounded on the bits of
+ * sigma, the sign of tau breaking the ties of sigma. */
+namespace rn {
+
+template <typename T, int32_t kPrecision = kRuntimePrecision>
+HWY_INLINE auto is_native(const int32_t t) -> bool {
+  const int32_t precision = kPrecision == kRuntimePrecision ? t : kPrecision;
+  return precision >= prism::utils::IEEE754<T>::precision;
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto round(const D d, const V sigma, const V tau, const int32_t t)
+    -> V {
+  if (is_native<T, kPrecision>(t)) {
+    return sigma;
+  }
+  const int32_t precision = kPrecision == kRuntimePrecision ? t : kPrecision;
+  const hn::RebindToUnsigned<D> du;
+  using U = hn::TFromD<decltype(du)>;
+  constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  const int32_t shift = mantissa - (precision - 1);
+  const auto sign_mask = hn::Set(du, U{1} << (sizeof(U) * 8 - 1));
+
+  const auto bits = hn::BitCast(du, sigma);
+  const auto sign = hn::And(bits, sign_mask);
+  const auto abs = hn::AndNot(sign_mask, bits);
+
+  // x lies below |sigma| when tau points towards zero: a tie of sigma then
+  // rounds down. The all-ones lanes of the mask add -1 to the half ulp.
+  const auto tau_opposite = hn::Ne(
+      hn::And(hn::Xor(bits, hn::BitCast(du, tau)), sign_mask), hn::Zero(du));
+  const auto towards_zero =
+      hn::And(hn::RebindMask(du, hn::Ne(tau, hn::Zero(d))), tau_opposite);
+  const auto half = hn::Add(hn::Set(du, U{1} << (shift - 1)),
+                            hn::VecFromMask(du, towards_zero));
+
+  // A carry out of the mantissa moves to the next binade, or to infinity.
+  const auto mask = hn::Set(du, ~((U{1} << shift) - 1));
+  const auto rounded = hn::Or(sign, hn::And(hn::Add(abs, half), mask));
+  return hn::IfThenElse(hn::IsFinite(sigma), hn::BitCast(d, rounded), sigma);
+}
+
+} // namespace rn
+
+// True when x = sigma + tau is exactly representable at precision t in every
+// lane, where round returns sigma whatever the sample.
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_INLINE auto all_exact(const D d, const V sigma, const V tau,
+                          const prism::sr::ConfigSnapshot &config) -> bool {
+  const int32_t t = kPrecision == kRuntimePrecision ? config.virtual_precision
+                                                    : kPrecision;
+  const auto zero = hn::Zero(d);
+  const auto rho = hn::Sub(sigma, truncate_mantissa<kPrecision>(d, sigma, t));
+  return hn::AllTrue(d, hn::And(hn::Eq(rho, zero), hn::Eq(tau, zero)));
+}
+
+// round with the sample drawn by draw_z() only when some lane is inexact, as
+// the scalar round does: whole exact vectors, common on integer-valued data,
+// return sigma without touching the random stream. RN mode never draws.
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto round_lazy(const D d, const V sigma, const V tau,
+                            const Draw &draw_z,
+                            const prism::sr::ConfigSnapshot &config) -> V {
+  if (config.rounding_mode == prism::sr::PRISM_RN) {
+    return rn::round<kPrecision>(d, sigma, tau, config.virtual_precision);
+  }
+  if (all_exact<kPrecision>(d, sigma, tau, config)) {
+    prism::sr::count_exact_vector();
+    return sigma;
+  }
+  return round<kPrecision>(d, sigma, tau, draw_z(), config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto round(const D d, const V sigma, const V tau,
+                       const prism::sr::ConfigSnapshot &config) -> V {
+  return round_lazy(
+      d, sigma, tau, [&] { return sample_z(d, config); }, config);
+}
+
+/* Each operation comes in two forms: op(d, ...) draws the SR sample from the
+ * per-thread generator, op(d, ..., z) takes it from the caller as a vector
+ * of Uniform[0, 1) samples. op<kPrecision>(d, ..., draw_z, config) is the
+ * latter with the configuration of the caller, which array kernels snapshot
+ * once per call, t fixed at compile time unless kPrecision is
+ * kRuntimePrecision, and the sample returned by draw_z() only when needed
+ * (see round_lazy). In RN mode both forms round with rn::round; the array
+ * kernels call the rn:: operations at the end of this file instead. */
+
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
 HWY_FLATTEN auto add(const D d, const V a, const V b) -> V {
   const auto config = prism::sr::get_config_snapshot<T>();
@@ -648,6 +786,22 @@ HWY_FLATTEN auto add(const D d, const V a, const V b) -> V {
   return ret;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto add(const D d, const V a, const V b, const Draw &draw_z,
+                     const prism::sr::ConfigSnapshot &config) -> V {
+  V sigma;
+  V tau;
+  twosum(d, a, b, sigma, tau);
+  return round_lazy<kPrecision>(d, sigma, tau, draw_z, config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto add(const D d, const V a, const V b, const V z) -> V {
+  return add(
+      d, a, b, [&] { return z; }, prism::sr::get_config_snapshot<T>());
+}
+
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
 HWY_FLATTEN auto sub(const D d, const V a, const V b) -> V {
   dbg::debug_msg("\n[sr_sub] START");
@@ -657,6 +811,18 @@ HWY_FLATTEN auto sub(const D d, const V a, const V b) -> V {
   return ret;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sub(const D d, const V a, const V b, const Draw &draw_z,
+                     const prism::sr::ConfigSnapshot &config) -> V {
+  return add<kPrecision>(d, a, hn::Neg(b), draw_z, config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sub(const D d, const V a, const V b, const V z) -> V {
+  return add(d, a, hn::Neg(b), z);
+}
+
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
 HWY_FLATTEN auto mul(const D d, const V a, const V b) -> V {
   const auto config = prism::sr::get_config_snapshot<T>();
@@ -671,6 +837,22 @@ HWY_FLATTEN auto mul(const D d, const V a, const V b) -> V {
   return ret;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto mul(const D d, const V a, const V b, const Draw &draw_z,
+                     const prism::sr::ConfigSnapshot &config) -> V {
+  V sigma;
+  V tau;
+  twoprodfma(d, a, b, sigma, tau);
+  return round_lazy<kPrecision>(d, sigma, tau, draw_z, config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto mul(const D d, const V a, const V b, const V z) -> V {
+  return mul(
+      d, a, b, [&] { return z; }, prism::sr::get_config_snapshot<T>());
+}
+
 /*
 Algorithm 6.9. Division With Stochastic Rounding Without
 the Change of the Rounding Mode
@@ -686,12 +868,10 @@ the Change of the Rounding Mode
 9. return σ
 */
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
-HWY_FLATTEN auto div(const D d, const V a, const V b) -> V {
-  const auto config = prism::sr::get_config_snapshot<T>();
-  dbg::debug_msg("\n[sr_div] START");
+HWY_FLATTEN void div_error(const D d, const V a, const V b, V &sigma, V &tau) {
   dbg::debug_vec(d, "[sr_div] a", a);
   dbg::debug_vec(d, "[sr_div] b", b);
-  const auto sigma = hn::Div(a, b);
+  sigma = hn::Div(a, b);
   dbg::debug_vec(d, "[sr_div] σ", sigma);
 #if HWY_NATIVE_FMA
   const auto tau_p = hn::NegMulAdd(sigma, b, a);
@@ -703,8 +883,17 @@ HWY_FLATTEN auto div(const D d, const V a, const V b) -> V {
   const auto tau_p = fma_emul(d, neg_sigma, b, a);
 #endif
   dbg::debug_vec(d, "[sr_div] τ'", tau_p);
-  const auto tau = hn::Div(tau_p, b);
+  tau = hn::Div(tau_p, b);
   dbg::debug_vec(d, "[sr_div] τ", tau);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto div(const D d, const V a, const V b) -> V {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  dbg::debug_msg("\n[sr_div] START");
+  V sigma;
+  V tau;
+  div_error(d, a, b, sigma, tau);
   const auto ret = round(d, sigma, tau, config);
   dbg::debug_vec(d, "[sr_div] res", ret);
   dbg::debug_msg("[sr_div] END\n");
@@ -712,16 +901,39 @@ HWY_FLATTEN auto div(const D d, const V a, const V b) -> V {
   return ret;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto div(const D d, const V a, const V b, const Draw &draw_z,
+                     const prism::sr::ConfigSnapshot &config) -> V {
+  V sigma;
+  V tau;
+  div_error(d, a, b, sigma, tau);
+  return round_lazy<kPrecision>(d, sigma, tau, draw_z, config);
+}
+
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
-HWY_FLATTEN auto sqrt(const D d, const V a) -> V {
-  const auto config = prism::sr::get_config_snapshot<T>();
-  dbg::debug_msg("\n[sr_sqrt] START");
-  const auto sigma = hn::Sqrt(a);
+HWY_FLATTEN auto div(const D d, const V a, const V b, const V z) -> V {
+  return div(
+      d, a, b, [&] { return z; }, prism::sr::get_config_snapshot<T>());
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN void sqrt_error(const D d, const V a, V &sigma, V &tau) {
+  sigma = hn::Sqrt(a);
   // -sigma * sigma + a
   const auto tau_p = hn::NegMulAdd(sigma, sigma, a);
   const auto _div = hn::Div(tau_p, sigma);
   const auto half = hn::Set(d, 0.5);
-  const auto tau = hn::Mul(half, _div);
+  tau = hn::Mul(half, _div);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sqrt(const D d, const V a) -> V {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  dbg::debug_msg("\n[sr_sqrt] START");
+  V sigma;
+  V tau;
+  sqrt_error(d, a, sigma, tau);
   const auto ret = round(d, sigma, tau, config);
   dbg::debug_vec(d, "[sr_sqrt] res", ret);
   dbg::debug_msg("[sr_sqrt] END\n");
@@ -729,6 +941,22 @@ HWY_FLATTEN auto sqrt(const D d, const V a) -> V {
   return ret;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sqrt(const D d, const V a, const Draw &draw_z,
+                      const prism::sr::ConfigSnapshot &config) -> V {
+  V sigma;
+  V tau;
+  sqrt_error(d, a, sigma, tau);
+  return round_lazy<kPrecision>(d, sigma, tau, draw_z, config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sqrt(const D d, const V a, const V z) -> V {
+  return sqrt(
+      d, a, [&] { return z; }, prism::sr::get_config_snapshot<T>());
+}
+
 /*
 "Exact and Approximated error of the FMA"
 Sylvie Boldo, Jean-Michel Muller
@@ -742,19 +970,18 @@ Algorithm 5 (ErrFmaNearest):
   r2 = ◦(γ + α2)
 */
 template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
-HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c) -> V {
-  const auto config = prism::sr::get_config_snapshot<T>();
-  dbg::debug_msg("\n[sr_fma] START");
+HWY_FLATTEN void fma_error(const D d, const V a, const V b, const V c, V &r1,
+                           V &r2) {
   dbg::debug_vec(d, "[sr_fma] a", a);
   dbg::debug_vec(d, "[sr_fma] b", b);
   dbg::debug_vec(d, "[sr_fma] c", c);
 #if HWY_NATIVE_FMA
-  const auto r1 = hn::MulAdd(a, b, c);
+  r1 = hn::MulAdd(a, b, c);
 #else
 #if defined(HWY_COMPILE_ONLY_STATIC) or defined(WARN_FMA_EMULATION)
 #warning "FMA not supported, using emulation (slow)"
 #endif
-  const auto r1 = fma_emul(d, a, b, c);
+  r1 = fma_emul(d, a, b, c);
 #endif
   V u1;
   V u2;
@@ -763,13 +990,21 @@ HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c) -> V {
   V beta1;
   V beta2;
   V gamma;
-  V r2;
   twoprodfma(d, a, b, u1, u2);
   twosum(d, c, u2, alpha1, alpha2);
   twosum(d, u1, alpha1, beta1, beta2);
   const auto beta1_sub_r1 = hn::Sub(beta1, r1);
   gamma = hn::Add(beta1_sub_r1, beta2);
   r2 = hn::Add(gamma, alpha2);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c) -> V {
+  const auto config = prism::sr::get_config_snapshot<T>();
+  dbg::debug_msg("\n[sr_fma] START");
+  V r1;
+  V r2;
+  fma_error(d, a, b, c, r1, r2);
   const auto res = round(d, r1, r2, config);
   dbg::debug_vec(d, "[sr_fma] res", res);
   dbg::debug_msg("[sr_fma] END\n");
@@ -777,6 +1012,103 @@ HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c) -> V {
   return res;
 }
 
+template <int32_t kPrecision = kRuntimePrecision, class D, class Draw,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c,
+                     const Draw &draw_z,
+                     const prism::sr::ConfigSnapshot &config) -> V {
+  V r1;
+  V r2;
+  fma_error(d, a, b, c, r1, r2);
+  return round_lazy<kPrecision>(d, r1, r2, draw_z, config);
+}
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c, const V z)
+    -> V {
+  return fma(
+      d, a, b, c, [&] { return z; }, prism::sr::get_config_snapshot<T>());
+}
+
+/* Round-to-nearest kernels, run in place of the SR pipeline in RN mode: the
+ * native operation at hardware precision, the error-free transformation
+ * rounded by rn::round at reduced precision. t is read as kPrecision when it
+ * is not kRuntimePrecision. */
+namespace rn {
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto add(const D d, const V a, const V b, const int32_t t) -> V {
+  if (is_native<T, kPrecision>(t)) {
+    return hn::Add(a, b);
+  }
+  V sigma;
+  V tau;
+  twosum(d, a, b, sigma, tau);
+  return round<kPrecision>(d, sigma, tau, t);
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sub(const D d, const V a, const V b, const int32_t t) -> V {
+  return add<kPrecision>(d, a, hn::Neg(b), t);
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto mul(const D d, const V a, const V b, const int32_t t) -> V {
+  if (is_native<T, kPrecision>(t)) {
+    return hn::Mul(a, b);
+  }
+  V sigma;
+  V tau;
+  twoprodfma(d, a, b, sigma, tau);
+  return round<kPrecision>(d, sigma, tau, t);
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto div(const D d, const V a, const V b, const int32_t t) -> V {
+  if (is_native<T, kPrecision>(t)) {
+    return hn::Div(a, b);
+  }
+  V sigma;
+  V tau;
+  div_error(d, a, b, sigma, tau);
+  return round<kPrecision>(d, sigma, tau, t);
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto sqrt(const D d, const V a, const int32_t t) -> V {
+  if (is_native<T, kPrecision>(t)) {
+    return hn::Sqrt(a);
+  }
+  V sigma;
+  V tau;
+  sqrt_error(d, a, sigma, tau);
+  return round<kPrecision>(d, sigma, tau, t);
+}
+
+template <int32_t kPrecision = kRuntimePrecision, class D,
+          class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+HWY_FLATTEN auto fma(const D d, const V a, const V b, const V c,
+                     const int32_t t) -> V {
+  if (is_native<T, kPrecision>(t)) {
+#if HWY_NATIVE_FMA
+    return hn::MulAdd(a, b, c);
+#else
+    return fma_emul(d, a, b, c);
+#endif
+  }
+  V r1;
+  V r2;
+  fma_error(d, a, b, c, r1, r2);
+  return round<kPrecision>(d, r1, r2, t);
+}
+
+} // namespace rn
+
 // NOLINTNEXTLINE(google-readability-namespace-comments)
 } // namespace prism::sr::vector::PRISM_DISPATCH::HWY_NAMESPACE
 HWY_AFTER_NAMESPACE();
@@ -12,6 +12,121 @@ namespace prism::sr::vector::PRISM_DISPATCH {
 
 #include "src/generic_vector.h"
 
+namespace variable {
+
+/* Variable size functions with caller-supplied randomness.
+ * z holds one stochastic rounding sample per element: *_rand takes values
+ * in [0, 1), *_randbits takes random bits, of which the top 23 (binary32) or
+ * 52 (binary64) bits are used. The same z gives the same result, and z is
+ * ignored in RN mode. */
+
+/* IEEE-754 binary32 */
+
+void addf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                 const float *HWY_RESTRICT z, float *HWY_RESTRICT result,
+                 size_t count);
+
+void subf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                 const float *HWY_RESTRICT z, float *HWY_RESTRICT result,
+                 size_t count);
+
+void mulf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                 const float *HWY_RESTRICT z, float *HWY_RESTRICT result,
+                 size_t count);
+
+void divf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                 const float *HWY_RESTRICT z, float *HWY_RESTRICT result,
+                 size_t count);
+
+void sqrtf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT z,
+                  float *HWY_RESTRICT result, size_t count);
+
+void fmaf32_rand(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                 const float *HWY_RESTRICT c, const float *HWY_RESTRICT z,
+                 float *HWY_RESTRICT result, size_t count);
+
+void addf32_randbits(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                     const uint32_t *HWY_RESTRICT z,
+                     float *HWY_RESTRICT result, size_t count);
+
+void subf32_randbits(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                     const uint32_t *HWY_RESTRICT z,
+                     float *HWY_RESTRICT result, size_t count);
+
+void mulf32_randbits(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                     const uint32_t *HWY_RESTRICT z,
+                     float *HWY_RESTRICT result, size_t count);
+
+void divf32_randbits(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                     const uint32_t *HWY_RESTRICT z,
+                     float *HWY_RESTRICT result, size_t count);
+
+void sqrtf32_randbits(const float *HWY_RESTRICT a,
+                      const uint32_t *HWY_RESTRICT z,
+                      float *HWY_RESTRICT result, size_t count);
+
+void fmaf32_randbits(const float *HWY_RESTRICT a, const float *HWY_RESTRICT b,
+                     const float *HWY_RESTRICT c,
+                     const uint32_t *HWY_RESTRICT z,
+                     float *HWY_RESTRICT result, size_t count);
+
+/* IEEE-754 binary64 */
+
+void addf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
+                 const double *HWY_RESTRICT z, double *HWY_RESTRICT result,
+                 size_t count);
+
+void subf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
+                 const double *HWY_RESTRICT z, double *HWY_RESTRICT result,
+                 size_t count);
+
+void mulf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
+                 const double *HWY_RESTRICT z, double *HWY_RESTRICT result,
+                 size_t count);
+
+void divf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
+                 const double *HWY_RESTRICT z, double *HWY_RESTRICT result,
+                 size_t count);
+
+void sqrtf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT z,
+                  double *HWY_RESTRICT result, size_t count);
+
+void fmaf64_rand(const double *HWY_RESTRICT a, const double *HWY_RESTRICT b,
+                 const double *HWY_RESTRICT c, const double *HWY_RESTRICT z,
+                 double *HWY_RESTRICT result, size_t count);
+
+void addf64_randbits(const double *HWY_RESTRICT a,
+                     const double *HWY_RESTRICT b,
+                     const uint64_t *HWY_RESTRICT z,
+                     double *HWY_RESTRICT result, size_t count);
+
+void subf64_randbits(const double *HWY_RESTRICT a,
+                     const double *HWY_RESTRICT b,
+                     const uint64_t *HWY_RESTRICT z,
+                     double *HWY_RESTRICT result, size_t count);
+
+void mulf64_randbits(const double *HWY_RESTRICT a,
+                     const double *HWY_RESTRICT b,
+                     const uint64_t *HWY_RESTRICT z,
+                     double *HWY_RESTRICT result, size_t count);
+
+void divf64_randbits(const double *HWY_RESTRICT a,
+                     const double *HWY_RESTRICT b,
+                     const uint64_t *HWY_RESTRICT z,
+                     double *HWY_RESTRICT result, size_t count);
+
+void sqrtf64_randbits(const double *HWY_RESTRICT a,
+                      const uint64_t *HWY_RESTRICT z,
+                      double *HWY_RESTRICT result, size_t count);
+
+void fmaf64_randbits(const double *HWY_RESTRICT a,
+                     const double *HWY_RESTRICT b,
+                     const double *HWY_RESTRICT c,
+                     const uint64_t *HWY_RESTRICT z,
+                     double *HWY_RESTRICT result, size_t count);
+
+} // namespace variable
+
 } // namespace prism::sr::vector::PRISM_DISPATCH
 
 #endif // __PRISM_SR_HW_H__
\ No newline at end of file
@@ -32,15 +32,9 @@ template <typename T> HWY_FLATTEN auto round(T a) -> T {
   prism::utils::binaryN<T> a_bits = {.f = a};
   using U = decltype(a_bits.u);
   constexpr U one = 1;
-#ifdef PRISM_RANDOM_FULLBITS
+  // one bit of the per-thread bit pool gives 1 or -1
   const auto rand = rng::randombit(U{});
-  // get 1 or -1
   a_bits.i += 1 - (rand << one);
-#else
-  const auto rand = rng::random();
-  // get the last bit of the random number to get -1 or 1
-  a_bits.i += 1 - ((rand & one) << one);
-#endif
   debug_print("rand     = 0x%02x\n", rand);
   debug_print("round(a) = %.13a\n", a);
   debug_end();
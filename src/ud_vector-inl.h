@@ -47,15 +47,9 @@ HWY_FLATTEN auto round(const D d, const V a) -> V {
   const auto is_finite = hn::And(is_not_zero, hn::IsFinite(a));
   const auto must_be_rounded = is_finite;
 
-  // rand = 1 - 2 * (z & 1)
-#ifdef PRISM_RANDOM_FULLBITS
+  // rand = 1 - 2 * z, z being one bit-plane of the per-thread bit pool
   const auto z = rng::randombit(u);
   const auto z_last_bit = hn::ResizeBitCast(di, z);
-#else
-  const auto z = rng::random(u);
-  const auto z_di = hn::ResizeBitCast(di, z);
-  const auto z_last_bit = hn::And(one_di, z_di);
-#endif
 
   const auto dz = hn::DFromV<decltype(z)>{};
   dbg::debug_vec(dz, "[round] z", z);
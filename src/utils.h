@@ -4,6 +4,7 @@
 #include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <type_traits>
 
@@ -225,6 +226,97 @@ inline std::atomic<int32_t> default_virtual_precision_f64{
     utils::IEEE754<double>::precision};
 inline std::atomic<int32_t> default_rounding_mode{PRISM_SR};
 
+// Random-bit budget: number of random bits drawn per lane for the SR sample z.
+// 0 draws a full-resolution uniform (23 bits for binary32, 52 for binary64);
+// r in {1, 2, 4, 8, 16} draws r bits so one 64-bit random word feeds 64 / r
+// lanes. z then takes the 2^r midpoints (2c + 1) / 2^(r + 1), which bounds
+// the bias of the rounding probability by 2^-(r + 1). The build option sets
+// the initial value.
+#ifndef PRISM_SR_RANDOM_BITS
+#define PRISM_SR_RANDOM_BITS 0
+#endif
+constexpr int32_t PRISM_RANDOM_BITS_FULL = 0;
+constexpr int32_t PRISM_RANDOM_BITS_MAX = 16;
+
+constexpr auto is_valid_random_bits(int32_t bits) -> bool {
+  return bits == PRISM_RANDOM_BITS_FULL ||
+         (bits > 0 && bits <= PRISM_RANDOM_BITS_MAX &&
+          (bits & (bits - 1)) == 0);
+}
+static_assert(is_valid_random_bits(PRISM_SR_RANDOM_BITS),
+              "PRISM_SR_RANDOM_BITS must be 0 or a power of 2 <= 16");
+
+inline std::atomic<int32_t> default_random_bits{PRISM_SR_RANDOM_BITS};
+
+// SR sampling across runs. A numerical study repeats the program R times and
+// estimates the result distribution from the runs; the sampling scheme
+// correlates the SR samples z of the runs to make that estimate converge
+// faster. Every run keeps marginally uniform samples, so each run alone is
+// still an unbiased SR execution.
+//  - MC: independent samples, the run index is ignored;
+//  - ANTITHETIC: runs 2k and 2k + 1 share one random stream and use z and
+//    its mirror (1 - 2^-p) - z, p the mantissa width;
+//  - QMC: all runs share one random stream; run r uses z XOR v(r), v(r) being
+//    the r-th point of the base-2 van der Corput sequence (random digital
+//    shift). Any 2^m consecutive runs starting at a multiple of 2^m then put
+//    exactly one z in each interval [k / 2^m, (k + 1) / 2^m).
+// Selected with PRISM_SR_SAMPLING (mc, antithetic or qmc) and PRISM_SR_RUN,
+// the index of the run.
+constexpr int32_t PRISM_SAMPLING_MC = 0;
+constexpr int32_t PRISM_SAMPLING_ANTITHETIC = 1;
+constexpr int32_t PRISM_SAMPLING_QMC = 2;
+
+constexpr auto is_valid_sampling(int32_t sampling) -> bool {
+  return sampling >= PRISM_SAMPLING_MC && sampling <= PRISM_SAMPLING_QMC;
+}
+
+inline auto sampling_from_env() -> int32_t {
+  const char *env = getenv("PRISM_SR_SAMPLING");
+  if (env == nullptr) {
+    return PRISM_SAMPLING_MC;
+  }
+  if (strcmp(env, "antithetic") == 0) {
+    return PRISM_SAMPLING_ANTITHETIC;
+  }
+  if (strcmp(env, "qmc") == 0) {
+    return PRISM_SAMPLING_QMC;
+  }
+  return PRISM_SAMPLING_MC;
+}
+
+inline auto sr_run_from_env() -> uint64_t {
+  const char *env = getenv("PRISM_SR_RUN");
+  if (env == nullptr) {
+    return 0;
+  }
+  char *endptr = nullptr;
+  const uint64_t run = strtoull(env, &endptr, 10);
+  return *endptr == '\0' ? run : 0;
+}
+
+// Bit-reversed run index: its top bits are the van der Corput point v(run)
+// and its top bit is the parity of the run.
+constexpr auto reverse_bits(uint64_t x) -> uint64_t {
+  uint64_t r = 0;
+  for (int i = 0; i < 64; ++i, x >>= 1) {
+    r = (r << 1) | (x & 1);
+  }
+  return r;
+}
+
+inline std::atomic<int32_t> default_sampling{sampling_from_env()};
+inline std::atomic<uint64_t> default_sr_run{sr_run_from_env()};
+
+// Reproducible mode of the SR array functions: the SR sample of element i of
+// an array op only depends on (seed, thread, call index, i), not on the vector
+// length of the dispatch target. Selected with PRISM_SR_REPRODUCIBLE=1.
+inline auto reproducible_from_env() -> bool {
+  const char *env = getenv("PRISM_SR_REPRODUCIBLE");
+  return env != nullptr && strcmp(env, "0") != 0;
+}
+
+inline std::atomic<bool> default_reproducible{reproducible_from_env()};
+
 // Bumped by every process-wide setter. Release/acquire pairing with the
 // defaults above: a thread that sees a new epoch also sees the values that
 // were published before it.
@@ -238,11 +330,19 @@ inline thread_local int32_t virtual_precision_f64 =
     default_virtual_precision_f64.load(std::memory_order_relaxed);
 inline thread_local int32_t rounding_mode =
     default_rounding_mode.load(std::memory_order_relaxed);
+inline thread_local int32_t random_bits =
+    default_random_bits.load(std::memory_order_relaxed);
+inline thread_local int32_t sampling =
+    default_sampling.load(std::memory_order_relaxed);
+inline thread_local uint64_t sr_run_shift =
+    reverse_bits(default_sr_run.load(std::memory_order_relaxed));
+inline thread_local bool reproducible =
+    default_reproducible.load(std::memory_order_relaxed);
 inline thread_local uint32_t observed_epoch = 0;
 
 // Adopts the process-wide configuration if it changed since this thread last
-// looked. All three settings refresh together, so a kernel cannot mix a
-// precision from one epoch with a rounding mode from another.
+// looked. All settings refresh together, so a kernel cannot mix a precision
+// from one epoch with a rounding mode from another.
 inline void refresh_thread_config() {
   const uint32_t epoch = config_epoch.load(std::memory_order_acquire);
   if (epoch == observed_epoch) {
@@ -253,12 +353,19 @@ inline void refresh_thread_config() {
   virtual_precision_f64 =
       default_virtual_precision_f64.load(std::memory_order_relaxed);
   rounding_mode = default_rounding_mode.load(std::memory_order_relaxed);
+  random_bits = default_random_bits.load(std::memory_order_relaxed);
+  sampling = default_sampling.load(std::memory_order_relaxed);
+  sr_run_shift = reverse_bits(default_sr_run.load(std::memory_order_relaxed));
+  reproducible = default_reproducible.load(std::memory_order_relaxed);
   observed_epoch = epoch;
 }
 
 struct ConfigSnapshot {
   int32_t virtual_precision;
   int32_t rounding_mode;
+  int32_t random_bits;
+  int32_t sampling;
+  uint64_t run_shift;
 };
 
 // Refresh once, then copy the configuration relevant to one arithmetic
@@ -267,9 +374,11 @@ struct ConfigSnapshot {
 template <typename T> inline auto get_config_snapshot() -> ConfigSnapshot {
   refresh_thread_config();
   if constexpr (std::is_same_v<T, float>) {
-    return {virtual_precision_f32, rounding_mode};
+    return {virtual_precision_f32, rounding_mode, random_bits, sampling,
+            sr_run_shift};
   } else if constexpr (std::is_same_v<T, double>) {
-    return {virtual_precision_f64, rounding_mode};
+    return {virtual_precision_f64, rounding_mode, random_bits, sampling,
+            sr_run_shift};
   } else {
     static_assert(!sizeof(T), "get_config_snapshot: unsupported type");
   }
@@ -291,6 +400,11 @@ inline auto get_rounding_mode() -> int32_t {
   return rounding_mode;
 }
 
+inline auto get_random_bits() -> int32_t {
+  refresh_thread_config();
+  return random_bits;
+}
+
 // Thread-local override. Stamps the current epoch so the value survives until
 // the next process-wide setter, which discards it.
 template <typename T> inline void set_virtual_precision(int32_t t) {
@@ -313,6 +427,12 @@ inline void set_rounding_mode(int32_t mode) {
   rounding_mode = mode;
 }
 
+inline void set_random_bits(int32_t bits) {
+  assert(is_valid_random_bits(bits));
+  refresh_thread_config();
+  random_bits = bits;
+}
+
 // Process-wide setters. Publish the new value, then bump the epoch so every
 // other thread picks it up on its next operation.
 template <typename T> inline void set_default_virtual_precision(int32_t t) {
@@ -335,6 +455,91 @@ inline void set_default_rounding_mode(int32_t mode) {
   config_epoch.fetch_add(1, std::memory_order_release);
 }
 
+inline void set_default_random_bits(int32_t bits) {
+  assert(is_valid_random_bits(bits));
+  default_random_bits.store(bits, std::memory_order_relaxed);
+  config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+// Process-wide only: the run index describes the whole process. The random
+// stream of a run depends on the sampling scheme (see stream_seed):
+// interflop_prism_set_sr_sampling also reseeds every thread.
+inline void set_default_sampling(int32_t mode, uint64_t run) {
+  assert(is_valid_sampling(mode));
+  default_sampling.store(mode, std::memory_order_relaxed);
+  default_sr_run.store(run, std::memory_order_relaxed);
+  config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+inline auto get_sampling() -> int32_t {
+  refresh_thread_config();
+  return sampling;
+}
+
+inline auto get_sr_run() -> uint64_t {
+  return default_sr_run.load(std::memory_order_relaxed);
+}
+
+// Process-wide only, like the sampling scheme.
+inline void set_default_reproducible(bool enable) {
+  default_reproducible.store(enable, std::memory_order_relaxed);
+  config_epoch.fetch_add(1, std::memory_order_release);
+}
+
+inline auto get_reproducible() -> bool {
+  refresh_thread_config();
+  return reproducible;
+}
+
+// Debug: vectors the SR vector kernels returned through the whole-vector
+// exactness fast path, without drawing a sample. Only counted in PRISM_DEBUG
+// builds; always 0 otherwise.
+inline std::atomic<uint64_t> exact_vectors{0};
+
+inline void count_exact_vector() {
+#ifdef PRISM_DEBUG
+  exact_vectors.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+// SplitMix64 output function.
+inline auto mix64(uint64_t z) -> uint64_t {
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+// Seed of the random stream of this run: antithetic pairs share the stream
+// of their pair, QMC runs all share the stream of the user seed. The pair
+// index is hashed into the seed rather than added to it, so that the pairs
+// of adjacent user seeds do not share their streams.
+inline auto stream_seed(uint64_t seed) -> uint64_t {
+  if (default_sampling.load(std::memory_order_relaxed) ==
+      PRISM_SAMPLING_ANTITHETIC) {
+    const uint64_t pair = default_sr_run.load(std::memory_order_relaxed) >> 1;
+    return mix64(seed ^ mix64(pair + UINT64_C(0x9e3779b97f4a7c15)));
+  }
+  return seed;
+}
+
+// Maps the sample z drawn from the random stream to the sample of this run.
+// z is a multiple of 2^-mantissa in [0, 1), so 1 + z is exact, and so is its
+// mirror (1 - 2^-mantissa) - z, which stays on the same grid in [0, 1).
+template <typename T>
+inline auto apply_sampling(const T z, const ConfigSnapshot &config) -> T {
+  constexpr int32_t mantissa = utils::IEEE754<T>::mantissa;
+  if (config.sampling == PRISM_SAMPLING_MC) {
+    return z;
+  }
+  if (config.sampling == PRISM_SAMPLING_ANTITHETIC) {
+    constexpr T kLast = T{1} - T{1} / static_cast<T>(uint64_t{1} << mantissa);
+    return (config.run_shift >> 63) != 0 ? kLast - z : z;
+  }
+  utils::binaryN<T> bits = {.f = T{1} + z};
+  bits.u ^= static_cast<decltype(bits.u)>(config.run_shift >> (64 - mantissa));
+  return bits.f - T{1};
+}
+
 // Helper to mask off the lower bits of the mantissa to match a virtual
 // precision t
 template <typename T>
@@ -358,6 +563,42 @@ inline auto truncate_mantissa(const T val, const int32_t t) -> T {
   std::memcpy(&res, &bits, sizeof(T));
   return res;
 }
+
+// Round-to-nearest at precision t, ties away from zero, of x = sigma + tau
+// with sigma = RN(x) at hardware precision, as integer operations on the bits
+// of sigma: half an ulp_t is added to |sigma| and the bits below ulp_t are
+// cleared. sigma alone only misses the direction when it is halfway between
+// two values at precision t, where x is on the side of tau: one less is added
+// when tau points towards zero. Carries move up a binade, or to infinity.
+// Non-finite sigma, and any sigma at hardware precision, are returned as is.
+template <typename T>
+inline auto round_nearest(const T sigma, const T tau, const int32_t t) -> T {
+  constexpr int32_t mantissa = prism::utils::IEEE754<T>::mantissa;
+  using U = typename prism::utils::IEEE754<T>::U;
+  constexpr U inf_nan_mask = prism::utils::IEEE754<T>::inf_nan_mask;
+  constexpr U sign_mask = static_cast<U>(1) << (sizeof(U) * 8 - 1);
+
+  U bits;
+  std::memcpy(&bits, &sigma, sizeof(T));
+  if (t >= mantissa + 1 || (bits & inf_nan_mask) == inf_nan_mask) {
+    return sigma;
+  }
+
+  U tau_bits;
+  std::memcpy(&tau_bits, &tau, sizeof(T));
+  const bool towards_zero = tau != 0 && ((bits ^ tau_bits) & sign_mask) != 0;
+
+  const int32_t shift = mantissa - (t - 1);
+  const U half = static_cast<U>(1) << (shift - 1);
+  const U mask = ~((static_cast<U>(1) << shift) - 1);
+  const U abs = bits & ~sign_mask;
+  bits = (bits & sign_mask) |
+         ((abs + half - static_cast<U>(towards_zero)) & mask);
+
+  T res;
+  std::memcpy(&res, &bits, sizeof(T));
+  return res;
+}
 } // namespace prism::sr
 
 #endif // __PRISM_UTILS_H__
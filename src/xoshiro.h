@@ -1,40 +1,135 @@
 #ifndef __PRISM_XOSHIRO_H__
 #define __PRISM_XOSHIRO_H__
 
+#include <array>
 #include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <random>
+#include <thread>
+#include <vector>
 
+#include "src/utils.h"
+
+// Defined by the OpenMP runtime when the program links one.
+extern "C" int omp_get_thread_num(void) __attribute__((weak));
+
+namespace prism::rng_stream {
+
+constexpr uint64_t kUnbound = UINT64_MAX;
+
+// Logical stream index the calling thread is bound to, kUnbound if none.
+inline thread_local uint64_t bound = kUnbound;
+// Bumped when the calling thread changes stream; part of the epoch its RNG
+// state is checked against, so that the state restarts on the new stream.
+inline thread_local uint32_t rebinds = 0;
+
+// PRISM_RNG_STREAM=omp binds each thread to its OpenMP thread number.
+inline auto omp_from_env() -> bool {
+  const char *env = getenv("PRISM_RNG_STREAM");
+  return env != nullptr && strcmp(env, "omp") == 0 &&
+         omp_get_thread_num != nullptr;
+}
+
+inline auto use_omp() -> bool {
+  static const bool omp = omp_from_env();
+  return omp;
+}
+
+} // namespace prism::rng_stream
+
+// Stream index of the calling thread: the bound stream if any, else its
+// OpenMP thread number with PRISM_RNG_STREAM=omp, else the order in which
+// threads first touch the RNG.
 inline auto get_thread_id() -> uint64_t {
+  if (prism::rng_stream::bound != prism::rng_stream::kUnbound) {
+    return prism::rng_stream::bound;
+  }
   static std::atomic<uint64_t> thread_counter{0};
   thread_local uint64_t tid =
-      thread_counter.fetch_add(1, std::memory_order_relaxed);
+      prism::rng_stream::use_omp()
+          ? static_cast<uint64_t>(omp_get_thread_num())
+          : thread_counter.fetch_add(1, std::memory_order_relaxed);
   return tid;
 }
 
+inline auto seed_from_env() -> uint64_t {
+  const char *seed_str = getenv("PRISM_SEED");
+  if (seed_str == nullptr) {
+    std::random_device rd;
+    return rd();
+  }
+  char *endptr = nullptr;
+  const uint64_t seed = strtoll(seed_str, &endptr, 10);
+  return *endptr == '\0' ? seed : 0;
+}
+
+// Bumped by every set. Release/acquire pairing with the seed, as for
+// prism::sr::config_epoch: a thread that sees a new epoch also sees the new
+// seed. Each thread compares it with the epoch of its RNG state on every RNG
+// access (a plain load) and reseeds its state when it changed.
+inline std::atomic<uint32_t> seed_epoch{0};
+
 // inline with external linkage: static locals are shared across all TUs.
+// The seed comes from seed_from_env() on the first read only if no seed was
+// set before: a program that sets its seed first never reads PRISM_SEED nor
+// std::random_device. A set or the first read takes the state to kBusy, so
+// that a concurrent first read cannot overwrite a seed being set.
 inline auto seed_state(bool set = false, uint64_t new_seed = 0) -> uint64_t {
-  static bool initialized = false;
-  static uint64_t seed = 0;
-  if (set) {
-    seed = new_seed;
-    initialized = true;
-  } else if (not initialized) {
-    const char *seed_str = getenv("PRISM_SEED");
-    if (seed_str != nullptr) {
-      char *endptr = nullptr;
-      seed = strtoll(seed_str, &endptr, 10);
-      if (*endptr != '\0') {
-        seed = 0;
-      }
-    } else {
-      std::random_device rd;
-      seed = rd();
+  enum : uint32_t { kUnset, kBusy, kReady };
+  static std::atomic<uint64_t> seed{0};
+  static std::atomic<uint32_t> state{kUnset};
+  uint32_t current = state.load(std::memory_order_acquire);
+  for (;;) {
+    if (current == kReady and not set) {
+      return seed.load(std::memory_order_relaxed);
+    }
+    if (current == kBusy) {
+      std::this_thread::yield();
+      current = state.load(std::memory_order_acquire);
+    } else if (state.compare_exchange_weak(current, kBusy,
+                                           std::memory_order_acquire)) {
+      break;
     }
-    initialized = true;
   }
-  return seed;
+  const uint64_t value = set ? new_seed : seed_from_env();
+  seed.store(value, std::memory_order_relaxed);
+  state.store(kReady, std::memory_order_release);
+  if (set) {
+    seed_epoch.fetch_add(1, std::memory_order_release);
+  }
+  return value;
+}
+
+// Epoch an RNG state is valid for in the calling thread: it changes with
+// every reseed and with every change of stream of the thread.
+inline auto get_rng_epoch() -> uint32_t {
+  return seed_epoch.load(std::memory_order_acquire) +
+         prism::rng_stream::rebinds;
+}
+
+namespace prism::rng_stream {
+
+// The stream of the calling thread is fixed by the program, not by the order
+// in which threads start: a state left by an exited thread must not be
+// adopted.
+inline auto is_deterministic() -> bool {
+  return bound != kUnbound || use_omp();
+}
+
+// Binds the calling thread to stream index: it restarts at the beginning of
+// that stream on its next draw. Binding again to the same index is a no-op,
+// so a parallel region can bind on every entry.
+inline void bind(const uint64_t index) {
+  if (index != bound) {
+    bound = index;
+    ++rebinds;
+  }
 }
 
+} // namespace prism::rng_stream
+
 __attribute__((unused)) inline auto get_user_seed() -> uint64_t {
   return seed_state();
 }
@@ -43,6 +138,305 @@ __attribute__((unused)) inline auto set_user_seed(uint64_t seed) -> void {
   seed_state(true, seed);
 }
 
+// Seed of the random streams of this run: the user seed, adjusted by the SR
+// sampling scheme so that correlated runs share their stream.
+__attribute__((unused)) inline auto get_stream_seed() -> uint64_t {
+  return prism::sr::stream_seed(get_user_seed());
+}
+
+namespace prism::rng_stream {
+
+// Launcher variables holding the rank of the process, by priority.
+constexpr std::array<const char *, 4> kRankVariables = {
+    "PRISM_RANK", "OMPI_COMM_WORLD_RANK", "PMI_RANK", "SLURM_PROCID"};
+
+inline auto rank_from_env() -> uint64_t {
+  for (const char *name : kRankVariables) {
+    const char *value = getenv(name);
+    if (value == nullptr) {
+      continue;
+    }
+    char *endptr = nullptr;
+    const uint64_t rank = strtoull(value, &endptr, 10);
+    if (*value != '\0' && *endptr == '\0') {
+      return rank;
+    }
+  }
+  return 0;
+}
+
+// inline with external linkage: static locals are shared across all TUs.
+inline auto rank_state(bool set = false, uint64_t new_rank = 0) -> uint64_t {
+  static std::atomic<uint64_t> rank{rank_from_env()};
+  if (set) {
+    rank.store(new_rank, std::memory_order_relaxed);
+    // Like a reseed: every thread restarts on its stream of the new rank.
+    seed_epoch.fetch_add(1, std::memory_order_release);
+    return new_rank;
+  }
+  return rank.load(std::memory_order_relaxed);
+}
+
+inline auto get_rank() -> uint64_t { return rank_state(); }
+
+inline void set_rank(const uint64_t rank) { rank_state(true, rank); }
+
+} // namespace prism::rng_stream
+
+// Stream of the calling thread across all the processes of a job: the rank
+// of the process in the upper 32 bits, the stream of the thread in the lower
+// 32 bits. xoshiro streams are LongJump(index) apart, so ranks and threads
+// never overlap; Philox and AES take it as their stream word.
+inline auto get_stream_index() -> uint64_t {
+  return (prism::rng_stream::get_rank() << 32) |
+         (get_thread_id() & UINT64_C(0xFFFFFFFF));
+}
+
+namespace prism::reproducible {
+
+constexpr int kCallBits = 40;
+
+// Array ops run by the calling thread in reproducible mode, counted from the
+// last reseed or change of stream.
+inline thread_local uint64_t calls = 0;
+inline thread_local uint32_t calls_epoch = 0;
+
+// Counter-based stream of the next array op of the calling thread: the
+// thread id in the upper bits, the call index in the lower kCallBits bits.
+inline auto next_stream() -> uint64_t {
+  const uint32_t epoch = get_rng_epoch();
+  if (epoch != calls_epoch) {
+    calls = 0;
+    calls_epoch = epoch;
+  }
+  const uint64_t call = calls++ & ((UINT64_C(1) << kCallBits) - 1);
+  return (get_thread_id() << kCallBits) | call;
+}
+
+// Philox key of the array ops: the stream seed, made distinct per rank so
+// that the processes of a job get independent samples.
+inline auto key() -> uint64_t {
+  return get_stream_seed() ^
+         (prism::rng_stream::get_rank() * UINT64_C(0x9E3779B97F4A7C15));
+}
+
+} // namespace prism::reproducible
+
+namespace prism::rng_cache {
+
+// Capacity, in 64-bit words, of the per-thread scalar RNG cache. The cache
+// starts small and grows up to this capacity (see hwy::CachedXoshiro).
+constexpr uint64_t kMinCacheSize = 256;
+constexpr uint64_t kMaxCacheSize = UINT64_C(1) << 20;
+constexpr uint64_t kDefaultCacheSize = 8192;
+
+constexpr auto is_valid_cache_size(uint64_t words) -> bool {
+  return words >= kMinCacheSize && words <= kMaxCacheSize &&
+         (words & (words - 1)) == 0;
+}
+
+// PRISM_RNG_CACHE_SIZE gives the initial capacity; invalid values are ignored.
+inline auto cache_size_from_env() -> uint64_t {
+  const char *env = getenv("PRISM_RNG_CACHE_SIZE");
+  if (env == nullptr) {
+    return kDefaultCacheSize;
+  }
+  char *endptr = nullptr;
+  const uint64_t words = strtoull(env, &endptr, 10);
+  if (*endptr != '\0' || !is_valid_cache_size(words)) {
+    return kDefaultCacheSize;
+  }
+  return words;
+}
+
+inline auto cache_size_state() -> std::atomic<uint64_t> & {
+  static std::atomic<uint64_t> size{cache_size_from_env()};
+  return size;
+}
+
+inline auto get_cache_size() -> uint64_t {
+  return cache_size_state().load(std::memory_order_relaxed);
+}
+
+// Applies to the RNG states created afterwards; existing states keep theirs.
+// Invalid sizes are ignored, as in PRISM_RNG_CACHE_SIZE: the cache is refilled
+// in fixed slices and relies on a valid power-of-2 capacity.
+inline void set_cache_size(uint64_t words) {
+  if (!is_valid_cache_size(words)) {
+    return;
+  }
+  cache_size_state().store(words, std::memory_order_relaxed);
+}
+
+} // namespace prism::rng_cache
+
+namespace prism::state_pool {
+
+// Pool hit/miss counters, summed over the states of all targets. Only meant
+// for debugging and tuning.
+inline std::atomic<uint64_t> hits{0};
+inline std::atomic<uint64_t> misses{0};
+
+// PRISM_RNG_RECYCLE=0 disables recycling, e.g. to get the exact per-thread
+// streams of a fresh process.
+inline auto recycling_enabled() -> bool {
+  static const bool enabled = [] {
+    const char *env = getenv("PRISM_RNG_RECYCLE");
+    return env == nullptr || strcmp(env, "0") != 0;
+  }();
+  return enabled;
+}
+
+// Seed and process rank a state was created under. Its stream belongs to that
+// rank: a thread of another rank, e.g. one started after
+// interflop_prism_set_rank, must not resume it.
+struct Key {
+  uint64_t seed = 0;
+  uint64_t rank = 0;
+
+  auto operator==(const Key &other) const -> bool {
+    return seed == other.seed && rank == other.rank;
+  }
+};
+
+inline auto current_key() -> Key {
+  return {get_stream_seed(), prism::rng_stream::get_rank()};
+}
+
+/* Lock-free pool of per-thread RNG states.
+ * A thread that exits hands its state back instead of freeing it and the
+ * next thread that needs a state adopts it, skipping the allocation, the
+ * seeding jumps and the initial cache fill. The adopted state resumes the
+ * stream of the thread that released it exactly where that thread stopped.
+ * Thread ids are never reused, so the stream of the adopting thread itself is
+ * simply left unused and streams still do not overlap.
+ * A state is only adopted under the seed and the process rank it was created
+ * with (its Key); stale states are freed on the way. Slots are taken with an
+ * atomic exchange, so a state is owned by at most one thread and there is no
+ * ABA issue. The pool is trivially destructible so threads exiting during
+ * process shutdown can still release into it; states left in the pool are
+ * reclaimed by the OS. */
+template <typename T, std::size_t kSlots = 64> class StatePool {
+public:
+  auto Acquire(const Key &key) -> std::unique_ptr<T> {
+    return Acquire(key, [](const T & /*unused*/) { return true; });
+  }
+
+  // accept(state) may reject a state, e.g. one sized for an older setting.
+  template <class Accept>
+  auto Acquire(const Key &key, Accept accept) -> std::unique_ptr<T> {
+    if (recycling_enabled()) {
+      for (auto &slot : slots_) {
+        if (slot.load(std::memory_order_relaxed) == nullptr) {
+          continue;
+        }
+        Entry *entry = slot.exchange(nullptr, std::memory_order_acquire);
+        if (entry == nullptr) {
+          continue;
+        }
+        std::unique_ptr<Entry> owned{entry};
+        if (owned->key == key && accept(*owned->state)) {
+          hits.fetch_add(1, std::memory_order_relaxed);
+          return std::move(owned->state);
+        }
+      }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  void Release(std::unique_ptr<T> state, const Key &key) {
+    if (state == nullptr || !recycling_enabled()) {
+      return;
+    }
+    auto entry = std::make_unique<Entry>(Entry{std::move(state), key});
+    for (auto &slot : slots_) {
+      Entry *expected = nullptr;
+      if (slot.compare_exchange_strong(expected, entry.get(),
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        entry.release();
+        return;
+      }
+    }
+    // Pool full: the state is freed.
+  }
+
+private:
+  struct Entry {
+    std::unique_ptr<T> state;
+    Key key;
+  };
+  std::array<std::atomic<Entry *>, kSlots> slots_{};
+};
+
+/* Owning pointer to the state of the calling thread that hands the state
+ * back to its pool when the thread exits. A state that is not recyclable is
+ * freed instead: one on a stream fixed by the program (bound or OpenMP
+ * threads), which a thread binding to that stream later restarts from its
+ * beginning, and one restored from a snapshot, whose position the saving
+ * thread may still be drawing from. An adopter would draw the same words. */
+template <typename T> class PooledPtr {
+public:
+  explicit PooledPtr(StatePool<T> &pool) : pool_{&pool} {}
+  PooledPtr(const PooledPtr &) = delete;
+  auto operator=(const PooledPtr &) -> PooledPtr & = delete;
+  ~PooledPtr() {
+    if (recyclable_) {
+      pool_->Release(std::move(state_), key_);
+    }
+  }
+
+  void reset(std::unique_ptr<T> state, const Key &key, const bool recyclable) {
+    state_ = std::move(state);
+    key_ = key;
+    recyclable_ = recyclable;
+  }
+
+  [[nodiscard]] auto get() const -> T * { return state_.get(); }
+  auto operator->() const -> T * { return state_.get(); }
+  auto operator*() const -> T & { return *state_; }
+  auto operator==(std::nullptr_t) const -> bool { return state_ == nullptr; }
+  auto operator!=(std::nullptr_t) const -> bool { return state_ != nullptr; }
+
+private:
+  StatePool<T> *pool_;
+  std::unique_ptr<T> state_;
+  Key key_{};
+  bool recyclable_{false};
+};
+
+} // namespace prism::state_pool
+
+namespace prism::rng_snapshot {
+
+constexpr uint64_t kMagic = UINT64_C(0x474e524d53495250); // "PRISMRNG"
+constexpr uint64_t kVersion = 2;
+
+/* Snapshot of the random state of the calling thread, for both the scalar
+ * and the vector API: engine state, scalar cache and partially consumed
+ * words. Restoring it, in any thread, replays the same random numbers from
+ * that point on. Only valid for the same build and dispatch target; restore
+ * returns false and leaves the state unchanged otherwise. Defined in
+ * xoshiro_vector.cpp. */
+auto save() -> std::vector<uint8_t>;
+auto restore(const void *data, std::size_t size) -> bool;
+
+} // namespace prism::rng_snapshot
+
+namespace prism::rng_fill {
+
+/* Bulk draws from the generator of the calling thread, through dynamic
+ * dispatch: n random words or Uniform[0, 1) values written to a caller
+ * buffer of any length and alignment, without allocating. Defined in
+ * xoshiro_vector.cpp. */
+void fill(uint32_t *data, std::size_t n);
+void fill(uint64_t *data, std::size_t n);
+void fill_uniform(float *data, std::size_t n);
+void fill_uniform(double *data, std::size_t n);
+
+} // namespace prism::rng_fill
+
 #endif // __PRISM_XOSHIRO_H__
 
 #if defined(PRISM_XOSHIRO_H_) == defined(HWY_TARGET_TOGGLE)
@@ -59,15 +453,20 @@ namespace prism::scalar::xoshiro::HWY_NAMESPACE {
 
 namespace internal {
 namespace hn = hwy::HWY_NAMESPACE;
-constexpr size_t kCacheSize = 1024 * 8ULL;
-using RNG = hn::CachedXoshiro<kCacheSize>;
+constexpr size_t kCacheSize = prism::rng_cache::kDefaultCacheSize;
+using RNG = hn::CachedXoshiro<kCacheSize, hn::VectorEngine>;
 auto get_rng() -> RNG *;
 void init_rng(std::uint64_t seed, std::uint64_t tid);
 } // namespace internal
 
 auto uniform(float) -> float;
 auto uniform(double) -> double;
+// Uniform drawn from `bits` random bits only (midpoint of one of 2^bits
+// cells), see prism::sr::default_random_bits.
+auto uniform(float, std::int32_t bits) -> float;
+auto uniform(double, std::int32_t bits) -> double;
 auto random() -> std::uint64_t;
+// One random bit, harvested from a per-thread 64-bit word.
 auto randombit(std::uint32_t) -> std::uint32_t;
 auto randombit(std::uint64_t) -> std::uint64_t;
 
@@ -77,21 +476,37 @@ namespace prism::vector::xoshiro::HWY_NAMESPACE {
 
 namespace internal {
 namespace hn = hwy::HWY_NAMESPACE;
-using RNG = hn::VectorXoshiro;
+using RNG = hn::VectorEngine;
+using Ring = hn::UniformRing<>;
+template <typename T> using Chunks = hn::ChunkPool<T>;
 using VU32 = hn::Vec<hn::ScalableTag<std::uint32_t>>;
 using VU64 = hn::Vec<hn::ScalableTag<std::uint64_t>>;
 using VF32 = hn::Vec<hn::ScalableTag<float>>;
 using VF64 = hn::Vec<hn::ScalableTag<double>>;
 auto get_rng() -> RNG *;
+auto get_ring() -> Ring *;
 void init_rng(std::uint64_t seed, std::uint64_t tid);
 } // namespace internal
 
 auto uniform(float) -> internal::VF32;
 auto uniform(double) -> internal::VF64;
+// Uniform drawn from `bits` random bits per lane only (midpoint of one of
+// 2^bits cells), see prism::sr::default_random_bits.
+auto uniform(float, std::int32_t bits) -> internal::VF32;
+auto uniform(double, std::int32_t bits) -> internal::VF64;
 auto random(std::uint32_t) -> internal::VU32;
 auto random(std::uint64_t) -> internal::VU64;
+// One random bit per lane, taken as a bit-plane of a per-thread pool: one
+// random vector serves 32 (u32) or 64 (u64) consecutive calls.
 auto randombit(std::uint32_t) -> internal::VU32;
 auto randombit(std::uint64_t) -> internal::VU64;
+// n random words or uniforms written to a caller buffer of any length and
+// alignment, without allocating. Values are drawn a whole vector at a time;
+// the lanes of the last vector beyond n are dropped.
+void fill(std::uint32_t *data, std::size_t n);
+void fill(std::uint64_t *data, std::size_t n);
+void fill_uniform(float *data, std::size_t n);
+void fill_uniform(double *data, std::size_t n);
 
 } // namespace prism::vector::xoshiro::HWY_NAMESPACE
 HWY_AFTER_NAMESPACE(); // at file scope
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include <execinfo.h>
 #include <memory>
+#include <vector>
 
 // First undef to prevent error when re-included.
 #undef HWY_TARGET_INCLUDE
@@ -26,76 +27,222 @@
 
 HWY_BEFORE_NAMESPACE(); // at file scope
 
-namespace prism::scalar::xoshiro::HWY_NAMESPACE {
+namespace prism::thread_rng::HWY_NAMESPACE {
 
-namespace internal {
-thread_local std::unique_ptr<RNG> rng = nullptr;
+namespace hn = hwy::HWY_NAMESPACE;
+using Cache = prism::scalar::xoshiro::HWY_NAMESPACE::internal::RNG;
+using Ring = prism::vector::xoshiro::HWY_NAMESPACE::internal::Ring;
+template <typename T>
+using Chunks = prism::vector::xoshiro::HWY_NAMESPACE::internal::Chunks<T>;
+
+/* Random state of a thread, shared by the scalar and the vector API. Scalar
+ * draws read the cache and vector draws take whole vectors from the engine
+ * the cache is refilled from, so a thread seeds, stores and keeps hot a
+ * single generator whichever API it uses. */
+struct State {
+  State(const std::uint64_t seed, const std::uint64_t tid,
+        const std::size_t capacity)
+      : cache{seed, tid, capacity} {}
+
+  Cache cache;
+  // Vector API: pre-generated uniforms and random-bit reservoirs. The
+  // bit-plane pools for randombit() are kept apart from the chunk pools so
+  // that UD and SR with a random-bit budget do not shorten each other's
+  // words.
+  Ring ring;
+  Chunks<std::uint32_t> chunks_u32;
+  Chunks<std::uint64_t> chunks_u64;
+  Chunks<std::uint32_t> bits_u32;
+  Chunks<std::uint64_t> bits_u64;
+  // Scalar API: random word being split into r-bit chunks by
+  // uniform(T, bits), and random word handed out bit by bit by randombit().
+  std::uint64_t chunk_word = 0;
+  std::int32_t chunk_left = 0;
+  std::uint64_t bit_word = 0;
+  std::int32_t bit_left = 0;
+
+  void SaveState(hn::internal::StateWriter &out) const {
+    cache.SaveState(out);
+    ring.SaveState(out);
+    chunks_u32.SaveState(out);
+    chunks_u64.SaveState(out);
+    bits_u32.SaveState(out);
+    bits_u64.SaveState(out);
+    out.Put(chunk_word);
+    out.Put(chunk_left);
+    out.Put(bit_word);
+    out.Put(bit_left);
+  }
+
+  auto RestoreState(hn::internal::StateReader &in) -> bool {
+    return cache.RestoreState(in) && ring.RestoreState(in) &&
+           chunks_u32.RestoreState(in) && chunks_u64.RestoreState(in) &&
+           bits_u32.RestoreState(in) && bits_u64.RestoreState(in) &&
+           in.Get(chunk_word) && in.Get(chunk_left) && chunk_left >= 0 &&
+           chunk_left <= UINT64_WIDTH && in.Get(bit_word) &&
+           in.Get(bit_left) && bit_left >= 0 && bit_left <= UINT64_WIDTH;
+  }
+};
+
+state_pool::StatePool<State> pool;
+
+// The state of the calling thread and the epoch (get_rng_epoch) it was seeded
+// under, kept together so that a draw does a single TLS lookup.
+struct Slot {
+  state_pool::PooledPtr<State> state{pool};
+  std::uint32_t epoch = 0;
+};
+thread_local Slot slot;
 
 void debug(const char *fmt, ...) {
 #if PRISM_RNG_DEBUG
   va_list args;
   va_start(args, fmt);
-  fprintf(stderr, "[PRISM Debug Scalar] ");
+  fprintf(stderr, "[PRISM Debug RNG] ");
   vfprintf(stderr, fmt, args);
   va_end(args);
 #endif
 }
 
-void init_rng(const std::uint64_t seed = get_user_seed(),
-              const std::uint64_t tid = get_thread_id()) {
+void init(const std::uint64_t seed, const std::uint64_t tid) {
 #if PRISM_RNG_DEBUG
   // WARNING: Do not use c++ ostream in the constructor as some of its internal
   // objects are not initialized yet. Use fprintf instead.
   debug("Initializing rng\n");
   debug("Target chosen: %s\n", hwy::TargetName(HWY_TARGET));
-  assert(rng == nullptr);
 #endif
-  rng = std::make_unique<RNG>(seed, tid);
+  slot.epoch = get_rng_epoch();
+  slot.state.reset(
+      std::make_unique<State>(seed, tid, rng_cache::get_cache_size()),
+      state_pool::Key{seed, rng_stream::get_rank()},
+      !rng_stream::is_deterministic());
 #if PRISM_RNG_DEBUG
-  debug("rng allocated at %p\n", (void *)rng.get());
+  debug("rng allocated at %p\n", (void *)slot.state.get());
 #endif
 }
 
-auto get_rng() -> RNG * {
-  if (rng == nullptr) {
-    init_rng();
+// First use in this thread: adopt the state of an exited thread when the pool
+// holds one for the current seed and rank, otherwise seed a new one. A thread
+// bound to a stream always starts on its own one, and frees it at exit (see
+// PooledPtr).
+void adopt_or_init() {
+  const auto key = state_pool::current_key();
+  // A state sized under an older cache setting is dropped.
+  const std::size_t capacity = rng_cache::get_cache_size();
+  auto state = rng_stream::is_deterministic()
+                   ? nullptr
+                   : pool.Acquire(key, [capacity](const State &cached) {
+                       return cached.cache.Capacity() == capacity;
+                     });
+  if (state == nullptr) {
+    init(key.seed, get_stream_index());
+    return;
+  }
+  slot.state.reset(std::move(state), key, true);
+}
+
+// First use, or the seed or the stream of the thread changed since this state
+// was seeded: the thread restarts on its stream of the current seed.
+HWY_NOINLINE void refresh(const std::uint32_t epoch) {
+  if (slot.state == nullptr) {
+    adopt_or_init();
+  } else {
+    init(get_stream_seed(), get_stream_index());
+  }
+  slot.epoch = epoch;
+}
+
+HWY_INLINE auto get() -> State * {
+  Slot &current = slot;
+  const std::uint32_t epoch = get_rng_epoch();
+  if (HWY_UNLIKELY(current.state == nullptr || epoch != current.epoch)) {
+    refresh(epoch);
   }
-  return rng.get();
+  return current.state.get();
+}
+
+// State read back from a snapshot, adopted only once the whole snapshot is
+// known to be valid.
+auto read_state(hn::internal::StateReader &in) -> std::unique_ptr<State> {
+  auto state = std::make_unique<State>(0, 0, rng_cache::get_cache_size());
+  if (!state->RestoreState(in)) {
+    return nullptr;
+  }
+  return state;
+}
+
+// A restored state replays a stream position the saving thread may still be
+// drawing from: it is freed at exit rather than pooled.
+void adopt_state(std::unique_ptr<State> state) {
+  slot.epoch = get_rng_epoch();
+  slot.state.reset(std::move(state), state_pool::current_key(), false);
+}
+
+} // namespace prism::thread_rng::HWY_NAMESPACE
+
+namespace prism::scalar::xoshiro::HWY_NAMESPACE {
+
+namespace internal {
+namespace thread_rng = prism::thread_rng::HWY_NAMESPACE;
+
+void init_rng(const std::uint64_t seed, const std::uint64_t tid) {
+  thread_rng::init(seed, tid);
+}
+
+auto get_rng() -> RNG * { return &thread_rng::get()->cache; }
+
+template <typename T> auto uniform_chunk(const std::int32_t bits) -> T {
+  auto *state = thread_rng::get();
+  if (HWY_UNLIKELY(state->chunk_left < bits)) {
+    state->chunk_word = state->cache();
+    state->chunk_left = UINT64_WIDTH;
+  }
+  state->chunk_left -= bits;
+  const std::uint64_t chunk = (state->chunk_word >> state->chunk_left) &
+                              ((UINT64_C(1) << bits) - 1);
+  // (2c + 1) * 2^-(bits + 1)
+  return static_cast<T>(2 * chunk + 1) * prism::utils::pow2<T>(-(bits + 1));
+}
+
+HWY_INLINE auto next_bit() -> std::uint64_t {
+  auto *state = thread_rng::get();
+  if (HWY_UNLIKELY(state->bit_left == 0)) {
+    state->bit_word = state->cache();
+    state->bit_left = UINT64_WIDTH;
+  }
+  return (state->bit_word >> --state->bit_left) & UINT64_C(1);
 }
 }; // namespace internal
 
 /* API */
 
-HWY_FLATTEN auto uniform(float /*unused*/) -> float {
-  return static_cast<float>(internal::get_rng()->Uniform());
+HWY_FLATTEN auto uniform(float f) -> float {
+  return internal::get_rng()->Uniform(f);
 }
 
 HWY_FLATTEN auto uniform(double /*unused*/) -> double {
   return internal::get_rng()->Uniform();
 }
 
+HWY_FLATTEN auto uniform(float /*unused*/, const std::int32_t bits) -> float {
+  return internal::uniform_chunk<float>(bits);
+}
+
+HWY_FLATTEN auto uniform(double /*unused*/, const std::int32_t bits)
+    -> double {
+  return internal::uniform_chunk<double>(bits);
+}
+
 HWY_FLATTEN auto random() -> std::uint64_t {
   return internal::get_rng()->operator()();
 }
 
 HWY_FLATTEN auto randombit(std::uint64_t /* unused */) -> std::uint64_t {
-  thread_local std::size_t idx = 0;
-  thread_local std::uint64_t u = random();
-  if (idx == UINT64_WIDTH) {
-    u = random();
-    idx = 0;
-  }
-  return (u >> idx++) & UINT64_C(1);
+  return internal::next_bit();
 }
 
 HWY_FLATTEN auto randombit(std::uint32_t /* unused */) -> std::uint32_t {
-  thread_local std::size_t idx = 0;
-  thread_local std::uint64_t u = random();
-  if (idx == UINT64_WIDTH) {
-    u = random();
-    idx = 0;
-  }
-  return (u >> idx++) & UINT64_C(1);
+  return static_cast<std::uint32_t>(internal::next_bit());
 }
 
 } // namespace prism::scalar::xoshiro::HWY_NAMESPACE
@@ -103,54 +250,51 @@ HWY_FLATTEN auto randombit(std::uint32_t /* unused */) -> std::uint32_t {
 namespace prism::vector::xoshiro::HWY_NAMESPACE {
 
 namespace hn = hwy::HWY_NAMESPACE;
-namespace dbg = prism::vector::HWY_NAMESPACE;
 namespace internal {
-thread_local std::unique_ptr<RNG> rng = nullptr;
+namespace thread_rng = prism::thread_rng::HWY_NAMESPACE;
 
-void debug(const char *fmt, ...) {
-#if PRISM_RNG_DEBUG
-  va_list args;
-  va_start(args, fmt);
-  fprintf(stderr, "[PRISM Debug Vector] ");
-  vfprintf(stderr, fmt, args);
-  va_end(args);
-#endif
+void init_rng(const std::uint64_t seed, const std::uint64_t tid) {
+  thread_rng::init(seed, tid);
 }
 
-void init_rng(const std::uint64_t seed = get_user_seed(),
-              const std::uint64_t tid = get_thread_id()) {
-#if PRISM_RNG_DEBUG
-  // WARNING: Do not use c++ ostream in the constructor as some of its internal
-  // objects are not initialized yet. Use fprintf instead.
-  debug("Initializing rng\n");
-  debug("Target chosen: %s\n", hwy::TargetName(HWY_TARGET));
-  assert(rng == nullptr);
-#endif
-  rng = std::make_unique<RNG>(seed, tid);
-  assert(rng != nullptr);
-#if PRISM_RNG_DEBUG
-  debug("rng allocated at %p\n", (void *)rng.get());
-#endif
-}
+auto get_rng() -> internal::RNG * { return &thread_rng::get()->cache.Engine(); }
 
-auto get_rng() -> internal::RNG * {
-  if (HWY_UNLIKELY(rng == nullptr)) {
-    init_rng();
-  }
-  assert(rng != nullptr);
-  return rng.get();
-}
+auto get_ring() -> internal::Ring * { return &thread_rng::get()->ring; }
 
 }; // namespace internal
 
 /* API */
 
 HWY_FLATTEN auto uniform(float f) -> internal::VF32 {
-  return internal::get_rng()->Uniform(f);
+  auto *state = internal::thread_rng::get();
+  return state->ring.Uniform(state->cache.Engine(), f);
 }
 
 HWY_FLATTEN auto uniform(double d) -> internal::VF64 {
-  return internal::get_rng()->Uniform(d);
+  auto *state = internal::thread_rng::get();
+  return state->ring.Uniform(state->cache.Engine(), d);
+}
+
+// One random vector feeds 32 / bits (binary32) or 64 / bits (binary64)
+// calls. z is the midpoint (2c + 1) * 2^-(bits + 1) of the chunk's cell.
+HWY_FLATTEN auto uniform(float /*unused*/, const std::int32_t bits)
+    -> internal::VF32 {
+  const hn::ScalableTag<float> d;
+  auto *state = internal::thread_rng::get();
+  const auto chunk = state->chunks_u32.Next(state->cache.Engine(), bits);
+  const float scale = prism::utils::pow2<float>(-bits);
+  return hn::MulAdd(hn::ConvertTo(d, chunk), hn::Set(d, scale),
+                    hn::Set(d, 0.5F * scale));
+}
+
+HWY_FLATTEN auto uniform(double /*unused*/, const std::int32_t bits)
+    -> internal::VF64 {
+  const hn::ScalableTag<double> d;
+  auto *state = internal::thread_rng::get();
+  const auto chunk = state->chunks_u64.Next(state->cache.Engine(), bits);
+  const double scale = prism::utils::pow2<double>(-bits);
+  return hn::MulAdd(hn::ConvertTo(d, chunk), hn::Set(d, scale),
+                    hn::Set(d, 0.5 * scale));
 }
 
 HWY_FLATTEN auto random(std::uint32_t u) -> internal::VU32 {
@@ -161,40 +305,82 @@ HWY_FLATTEN auto random(std::uint64_t u) -> internal::VU64 {
   return internal::get_rng()->operator()(u);
 }
 
-HWY_FLATTEN auto randombit(std::uint32_t u) -> internal::VU32 {
-  constexpr auto u32_tag = hn::DFromV<internal::VU32>();
-  
-  // Use a more efficient bit extraction by getting multiple random values
-  static thread_local size_t call_count = 0;
-  const auto rand_vec = random(u);
-  
-  // Extract different bits from the random vector for each lane
-  const auto shift_amounts = hn::Iota(u32_tag, call_count % 32);
-  const auto shifted = hn::Shr(rand_vec, shift_amounts);
-  const auto result = hn::And(shifted, hn::Set(u32_tag, UINT32_C(1)));
-  
-  call_count++;
-  return result;
-}
-
-HWY_FLATTEN auto randombit(std::uint64_t u) -> internal::VU64 {
-  constexpr auto u64_tag = hn::DFromV<internal::VU64>();
-  
-  // Use a more efficient bit extraction by getting multiple random values
-  static thread_local size_t call_count = 0;
-  const auto rand_vec = random(u);
-  
-  // Extract different bits from the random vector for each lane
-  const auto shift_amounts = hn::Iota(u64_tag, call_count % 64);
-  const auto shifted = hn::Shr(rand_vec, shift_amounts);
-  const auto result = hn::And(shifted, hn::Set(u64_tag, UINT64_C(1)));
-  
-  call_count++;
-  return result;
+HWY_FLATTEN auto randombit(std::uint32_t /*unused*/) -> internal::VU32 {
+  auto *state = internal::thread_rng::get();
+  return state->bits_u32.Next(state->cache.Engine(), 1);
+}
+
+HWY_FLATTEN auto randombit(std::uint64_t /*unused*/) -> internal::VU64 {
+  auto *state = internal::thread_rng::get();
+  return state->bits_u64.Next(state->cache.Engine(), 1);
+}
+
+HWY_FLATTEN void fill(std::uint32_t *HWY_RESTRICT data, const std::size_t n) {
+  internal::get_rng()->fill(data, n);
+}
+
+HWY_FLATTEN void fill(std::uint64_t *HWY_RESTRICT data, const std::size_t n) {
+  internal::get_rng()->fill(data, n);
+}
+
+HWY_FLATTEN void fill_uniform(float *HWY_RESTRICT data, const std::size_t n) {
+  internal::get_rng()->FillUniform(data, n);
+}
+
+HWY_FLATTEN void fill_uniform(double *HWY_RESTRICT data,
+                              const std::size_t n) {
+  internal::get_rng()->FillUniform(data, n);
 }
 
 } // namespace prism::vector::xoshiro::HWY_NAMESPACE
 
+namespace prism::rng_snapshot::HWY_NAMESPACE {
+
+namespace thread_rng = prism::thread_rng::HWY_NAMESPACE;
+
+// Header: magic, version, target. The target fixes the vector length, hence
+// the layout of the engine state and of the buffers.
+void save_state(std::vector<std::uint8_t> *out) {
+  hwy::HWY_NAMESPACE::internal::StateWriter writer{*out};
+  writer.Put(kMagic);
+  writer.Put(kVersion);
+  writer.Put(static_cast<std::int64_t>(HWY_TARGET));
+  thread_rng::get()->SaveState(writer);
+}
+
+auto restore_state(const std::uint8_t *data, const std::size_t size) -> bool {
+  hwy::HWY_NAMESPACE::internal::StateReader reader{data, size};
+  std::uint64_t magic = 0;
+  std::uint64_t version = 0;
+  std::int64_t target = 0;
+  if (!reader.Get(magic) || magic != kMagic || !reader.Get(version) ||
+      version != kVersion || !reader.Get(target) || target != HWY_TARGET) {
+    return false;
+  }
+  auto state = thread_rng::read_state(reader);
+  if (state == nullptr || !reader.Done()) {
+    return false;
+  }
+  thread_rng::adopt_state(std::move(state));
+  return true;
+}
+
+} // namespace prism::rng_snapshot::HWY_NAMESPACE
+
+namespace prism::rng_fill::HWY_NAMESPACE {
+
+namespace rng = prism::vector::xoshiro::HWY_NAMESPACE;
+
+// Distinct names for HWY_EXPORT, which does not take overloads.
+void fill_u32(std::uint32_t *data, const std::size_t n) { rng::fill(data, n); }
+void fill_u64(std::uint64_t *data, const std::size_t n) { rng::fill(data, n); }
+void fill_f32(float *data, const std::size_t n) { rng::fill_uniform(data, n); }
+void fill_f64(double *data, const std::size_t n) {
+  rng::fill_uniform(data, n);
+}
+
+} // namespace prism::rng_fill::HWY_NAMESPACE
+
 HWY_AFTER_NAMESPACE();
 
 #if HWY_ONCE
@@ -209,6 +395,49 @@ void debug(const char *fmt, ...) {
 #endif
 }
 
+namespace prism::rng_snapshot {
+
+HWY_EXPORT(save_state);
+HWY_EXPORT(restore_state);
+
+auto save() -> std::vector<std::uint8_t> {
+  std::vector<std::uint8_t> snapshot;
+  HWY_DYNAMIC_DISPATCH(save_state)(&snapshot);
+  return snapshot;
+}
+
+auto restore(const void *data, const std::size_t size) -> bool {
+  return HWY_DYNAMIC_DISPATCH(restore_state)(
+      static_cast<const std::uint8_t *>(data), size);
+}
+
+} // namespace prism::rng_snapshot
+
+namespace prism::rng_fill {
+
+HWY_EXPORT(fill_u32);
+HWY_EXPORT(fill_u64);
+HWY_EXPORT(fill_f32);
+HWY_EXPORT(fill_f64);
+
+void fill(std::uint32_t *data, const std::size_t n) {
+  HWY_DYNAMIC_DISPATCH(fill_u32)(data, n);
+}
+
+void fill(std::uint64_t *data, const std::size_t n) {
+  HWY_DYNAMIC_DISPATCH(fill_u64)(data, n);
+}
+
+void fill_uniform(float *data, const std::size_t n) {
+  HWY_DYNAMIC_DISPATCH(fill_f32)(data, n);
+}
+
+void fill_uniform(double *data, const std::size_t n) {
+  HWY_DYNAMIC_DISPATCH(fill_f64)(data, n);
+}
+
+} // namespace prism::rng_fill
+
 __attribute__((constructor)) void init() {
   hwy::GetChosenTarget().Update(hwy::SupportedTargets());
 #if PRISM_RNG_DEBUG
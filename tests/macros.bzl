@@ -113,7 +113,7 @@ def cc_test_gen_vector(name, src = None, deps = None, copts = COPTS, size = "sma
         features = ["vector"],
     )
 
-def cc_test_lib_gen(name, src = None, deps = None, copts = COPTS, linkopts = None, size = "small", dbg = False, mode = None):
+def cc_test_lib_gen(name, src = None, deps = None, copts = COPTS, linkopts = None, size = "small", dbg = False, mode = None, tags = None):
     srcs = src if src else [name + ".cpp"]
     srcs += HEADERS
     native.cc_test(
@@ -123,6 +123,7 @@ def cc_test_lib_gen(name, src = None, deps = None, copts = COPTS, linkopts = Non
         linkopts = linkopts,
         deps = get_deps(deps, mode, dbg),
         size = size,
+        tags = tags,
         visibility = ["//visibility:public"],
     )
 
@@ -0,0 +1,149 @@
+// The processes of a multi-process job share one seed and get disjoint
+// streams: thread stream i of rank r is xoshiro stream r * 2^32 + i. Ranks are
+// simulated with fork().
+
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "hwy/highway.h"
+
+#include "src/prism_api.h"
+#include "src/xoshiro.h"
+
+namespace rng = prism::scalar::xoshiro::HWY_NAMESPACE;
+
+namespace {
+
+constexpr uint64_t kSeed = 0x4A4B4CULL;
+constexpr uint64_t kRanks = 4;
+constexpr int kDraws = 1000;
+
+void ClearRankVariables() {
+  for (const char *name : prism::rng_stream::kRankVariables) {
+    unsetenv(name);
+  }
+}
+
+TEST(RankStreamsTest, RankFromLauncherVariables) {
+  ClearRankVariables();
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 0ULL);
+
+  setenv("SLURM_PROCID", "7", 1);
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 7ULL);
+  setenv("PMI_RANK", "5", 1);
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 5ULL);
+  setenv("OMPI_COMM_WORLD_RANK", "3", 1);
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 3ULL);
+  setenv("PRISM_RANK", "1", 1);
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 1ULL);
+
+  // Malformed values are skipped.
+  setenv("PRISM_RANK", "x", 1);
+  EXPECT_EQ(prism::rng_stream::rank_from_env(), 3ULL);
+  ClearRankVariables();
+}
+
+TEST(RankStreamsTest, GetSetRoundtrip) {
+  interflop_prism_set_rank(12);
+  EXPECT_EQ(interflop_prism_get_rank(), 12ULL);
+  interflop_prism_set_rank(0);
+  EXPECT_EQ(interflop_prism_get_rank(), 0ULL);
+}
+
+// Each child is one rank: it draws on its thread stream 0 and writes the words
+// to its pipe. Returns false if the child failed.
+auto RunRank(const uint64_t rank, std::vector<uint64_t> &words) -> bool {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  const pid_t pid = fork();
+  if (pid < 0) {
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    interflop_prism_set_rank(rank);
+    interflop_prism_bind_rng_stream(0);
+    std::vector<uint64_t> draws(kDraws);
+    for (auto &v : draws) {
+      v = rng::random();
+    }
+    const auto *bytes = reinterpret_cast<const char *>(draws.data());
+    std::size_t left = draws.size() * sizeof(uint64_t);
+    while (left > 0) {
+      const ssize_t n = write(fds[1], bytes, left);
+      if (n <= 0) {
+        _exit(1);
+      }
+      bytes += n;
+      left -= static_cast<std::size_t>(n);
+    }
+    close(fds[1]);
+    _exit(0);
+  }
+
+  close(fds[1]);
+  words.assign(kDraws, 0);
+  auto *bytes = reinterpret_cast<char *>(words.data());
+  std::size_t left = words.size() * sizeof(uint64_t);
+  while (left > 0) {
+    const ssize_t n = read(fds[0], bytes, left);
+    if (n <= 0) {
+      break;
+    }
+    bytes += n;
+    left -= static_cast<std::size_t>(n);
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return left == 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+TEST(RankStreamsTest, ForkedRanksGetDisjointStreams) {
+  interflop_prism_set_seed(kSeed);
+
+  std::set<uint64_t> seen;
+  for (uint64_t rank = 0; rank < kRanks; ++rank) {
+    std::vector<uint64_t> words;
+    ASSERT_TRUE(RunRank(rank, words)) << "rank " << rank;
+
+    rng::internal::RNG reference{kSeed, rank << 32};
+    for (int i = 0; i < kDraws; ++i) {
+      EXPECT_EQ(words[i], reference()) << "rank " << rank << ", draw " << i;
+    }
+    for (const uint64_t word : words) {
+      EXPECT_TRUE(seen.insert(word).second) << "rank " << rank;
+    }
+  }
+}
+
+// A thread that exits before interflop_prism_set_rank leaves a state on a
+// stream of the old rank: a thread started afterwards must not resume it,
+// since that rank's own process draws the same stream.
+TEST(RankStreamsTest, PooledStateKeepsItsRank) {
+  interflop_prism_set_seed(kSeed ^ 0x9001ULL);
+  interflop_prism_set_rank(0);
+  std::thread([] { rng::random(); }).join();
+
+  interflop_prism_set_rank(3);
+  uint64_t hits = 0;
+  interflop_prism_get_rng_pool_stats(&hits, nullptr);
+  std::thread([] { rng::random(); }).join();
+  uint64_t hits_after = 0;
+  interflop_prism_get_rng_pool_stats(&hits_after, nullptr);
+  EXPECT_EQ(hits_after, hits);
+
+  interflop_prism_set_rank(0);
+  interflop_prism_set_seed(kSeed);
+}
+
+} // namespace
@@ -135,3 +135,34 @@ TEST(RNModeTest, SubnormalValues) {
   prism::sr::set_virtual_precision<double>(53);
   interflop_prism_set_rounding_mode(INTERFLOP_PRISM_SR);
 }
+
+// The error of the fma decides: r1 alone, the native fma, sits on the tie
+// of the virtual precision and would round away from zero.
+TEST(RNModeTest, FmaRoundsTheExactResult) {
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_RN);
+
+  // (1 + 2^-12)^2 - (2^-12 + 2^-23) = 1 + 2^-12 - 2^-24, below the tie at
+  // t = 12.
+  prism::sr::set_virtual_precision<float>(12);
+  const float a_f = 1.0f + std::ldexp(1.0f, -12);
+  const float c_f = -(std::ldexp(1.0f, -12) + std::ldexp(1.0f, -23));
+  EXPECT_EQ(srd::fmaf32(a_f, a_f, c_f), 1.0f);
+  EXPECT_EQ(srd::fmaf32(a_f, a_f, 0.0f), 1.0f + std::ldexp(1.0f, -11));
+
+  // (1 + 2^-26)(1 + 2^-27) - (2^-26 + 2^-52) = 1 + 2^-27 - 2^-53, below the
+  // tie at t = 27.
+  prism::sr::set_virtual_precision<double>(27);
+  const double a_d = 1.0 + std::ldexp(1.0, -26);
+  const double b_d = 1.0 + std::ldexp(1.0, -27);
+  const double c_d = -(std::ldexp(1.0, -26) + std::ldexp(1.0, -52));
+  EXPECT_EQ(srd::fmaf64(a_d, b_d, c_d), 1.0);
+
+  // Native precision: the hardware fma.
+  prism::sr::set_virtual_precision<float>(24);
+  prism::sr::set_virtual_precision<double>(53);
+  EXPECT_EQ(srd::fmaf32(a_f, a_f, c_f), std::fma(a_f, a_f, c_f));
+  EXPECT_EQ(srd::fmaf64(a_d, b_d, c_d), std::fma(a_d, b_d, c_d));
+  EXPECT_TRUE(std::isnan(srd::fmaf64(NAN, 1.0, 1.0)));
+
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_SR);
+}
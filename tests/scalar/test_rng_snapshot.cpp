@@ -0,0 +1,128 @@
+// Saving the RNG state of a thread and restoring it later must replay the
+// exact same SR decisions, so that one phase of a program can be rerun on its
+// own.
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "src/prism_api.h"
+#include "src/sr_scalar.h"
+#include "src/utils.h"
+
+namespace srd = prism::sr::scalar::dynamic_dispatch;
+
+namespace {
+
+constexpr int kOps = 4096;
+// 1 + ulp / 3 rounds up with probability 1 / 3: the results record the
+// random decisions.
+constexpr float kA = 1.0F;
+constexpr float kB = 0x1.555556p-25F;
+constexpr double kAD = 1.0;
+constexpr double kBD = 0x1.5555555555555p-54;
+
+auto RunPhase() -> std::vector<double> {
+  std::vector<double> results;
+  results.reserve(2 * kOps);
+  for (int i = 0; i < kOps; ++i) {
+    results.push_back(srd::addf32(kA, kB));
+    results.push_back(srd::addf64(kAD, kBD));
+  }
+  return results;
+}
+
+auto Save() -> std::vector<uint8_t> {
+  std::vector<uint8_t> snapshot(interflop_prism_get_rng_state_size());
+  EXPECT_EQ(interflop_prism_save_rng_state(snapshot.data(), snapshot.size()),
+            snapshot.size());
+  return snapshot;
+}
+
+TEST(RngSnapshotTest, RestoreReplaysThePhase) {
+  RunPhase(); // move away from the initial state
+  const auto snapshot = Save();
+  const auto expected = RunPhase();
+
+  ASSERT_EQ(interflop_prism_restore_rng_state(snapshot.data(), snapshot.size()),
+            0);
+  EXPECT_EQ(RunPhase(), expected);
+
+  // A snapshot can be restored any number of times.
+  ASSERT_EQ(interflop_prism_restore_rng_state(snapshot.data(), snapshot.size()),
+            0);
+  EXPECT_EQ(RunPhase(), expected);
+}
+
+TEST(RngSnapshotTest, RestoreInAnotherThread) {
+  const auto snapshot = Save();
+  const auto expected = RunPhase();
+
+  std::vector<double> got;
+  std::thread worker([&] {
+    RunPhase(); // the worker's own stream, discarded by the restore
+    ASSERT_EQ(
+        interflop_prism_restore_rng_state(snapshot.data(), snapshot.size()), 0);
+    got = RunPhase();
+  });
+  worker.join();
+  EXPECT_EQ(got, expected);
+}
+
+// The restoring thread replays words the saving thread may still draw: its
+// state is freed at exit, never handed to a new thread.
+TEST(RngSnapshotTest, RestoredStateIsNotPooled) {
+  const uint64_t seed = interflop_prism_get_seed();
+  interflop_prism_set_seed(seed ^ UINT64_C(0x5EED5A7E));
+  const auto snapshot = Save();
+
+  std::thread([&] {
+    ASSERT_EQ(
+        interflop_prism_restore_rng_state(snapshot.data(), snapshot.size()), 0);
+    RunPhase();
+  }).join();
+
+  uint64_t hits = 0;
+  interflop_prism_get_rng_pool_stats(&hits, nullptr);
+  std::thread([] { srd::addf64(kAD, kBD); }).join();
+  uint64_t hits_after = 0;
+  interflop_prism_get_rng_pool_stats(&hits_after, nullptr);
+  EXPECT_EQ(hits_after, hits);
+
+  interflop_prism_set_seed(seed);
+}
+
+TEST(RngSnapshotTest, BufferTooSmall) {
+  std::vector<uint8_t> snapshot(interflop_prism_get_rng_state_size() - 1);
+  EXPECT_EQ(interflop_prism_save_rng_state(snapshot.data(), snapshot.size()),
+            0U);
+  EXPECT_EQ(interflop_prism_save_rng_state(nullptr, 0), 0U);
+}
+
+TEST(RngSnapshotTest, InvalidSnapshotLeavesTheStateUnchanged) {
+  const auto snapshot = Save();
+
+  auto truncated = snapshot;
+  truncated.pop_back();
+  EXPECT_EQ(
+      interflop_prism_restore_rng_state(truncated.data(), truncated.size()), -1);
+
+  auto bad_magic = snapshot;
+  bad_magic[0] ^= 1;
+  EXPECT_EQ(
+      interflop_prism_restore_rng_state(bad_magic.data(), bad_magic.size()), -1);
+
+  auto trailing = snapshot;
+  trailing.push_back(0);
+  EXPECT_EQ(
+      interflop_prism_restore_rng_state(trailing.data(), trailing.size()), -1);
+
+  EXPECT_EQ(interflop_prism_restore_rng_state(nullptr, 0), -1);
+
+  // The failed restores did not touch the state: it is still the one saved.
+  EXPECT_EQ(Save(), snapshot);
+}
+
+} // namespace
@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <future>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -68,3 +70,106 @@ TEST(SeedAPITest, DifferentSeedsDifferentSequences) {
   EXPECT_NE(seq1, seq2);
 }
 
+// Reseeding in process: the next draw of every thread, including threads that
+// already drew numbers, comes from its stream of the new seed.
+TEST(SeedAPITest, ReseedRestartsTheStream) {
+  constexpr int N = 1000;
+  auto draw = [] {
+    std::vector<uint64_t> seq(N);
+    for (auto &v : seq)
+      v = rng::random();
+    return seq;
+  };
+
+  interflop_prism_set_seed(7);
+  const auto seq1 = draw();
+  draw();
+  interflop_prism_set_seed(7);
+  EXPECT_EQ(draw(), seq1);
+  interflop_prism_set_seed(8);
+  EXPECT_NE(draw(), seq1);
+}
+
+TEST(SeedAPITest, ReseedReachesARunningThread) {
+  constexpr uint64_t seed = 0x5EED5EEDULL;
+  constexpr int N = 1000;
+  std::promise<void> warmed_up;
+  std::promise<void> reseeded;
+  auto warmed_up_signal = warmed_up.get_future();
+  auto reseed_signal = reseeded.get_future();
+
+  uint64_t tid = 0;
+  std::vector<uint64_t> got(N);
+  std::thread worker([&] {
+    tid = get_thread_id();
+    rng::random();
+    warmed_up.set_value();
+    reseed_signal.wait();
+    for (auto &v : got)
+      v = rng::random();
+  });
+
+  warmed_up_signal.wait();
+  interflop_prism_set_seed(seed);
+  reseeded.set_value();
+  worker.join();
+
+  rng::internal::RNG reference{seed, tid};
+  for (int i = 0; i < N; ++i) {
+    EXPECT_EQ(got[i], reference()) << "draw " << i;
+  }
+}
+
+// Threads bound to a stream index draw from that stream, whatever the order in
+// which they start.
+TEST(SeedAPITest, BoundThreadsFollowTheirIndex) {
+  constexpr uint64_t seed = 0xB0B0ULL;
+  constexpr int N = 1000;
+  constexpr uint64_t kStreams = 4;
+  interflop_prism_set_seed(seed);
+
+  std::vector<std::vector<uint64_t>> got(kStreams, std::vector<uint64_t>(N));
+  // Started one after the other, in reverse order of their index.
+  for (uint64_t k = kStreams; k-- > 0;) {
+    std::thread worker([&got, k] {
+      interflop_prism_bind_rng_stream(k);
+      EXPECT_EQ(interflop_prism_get_rng_stream(), k);
+      for (auto &v : got[k])
+        v = rng::random();
+    });
+    worker.join();
+  }
+
+  for (uint64_t k = 0; k < kStreams; ++k) {
+    rng::internal::RNG reference{seed, k};
+    for (int i = 0; i < N; ++i) {
+      EXPECT_EQ(got[k][i], reference()) << "stream " << k << ", draw " << i;
+    }
+  }
+}
+
+// Binding restarts the stream once; binding again to the same index, e.g. on
+// every entry of a parallel region, continues it.
+TEST(SeedAPITest, RebindToTheSameStreamContinues) {
+  constexpr uint64_t seed = 0xB1B1ULL;
+  constexpr uint64_t stream = 1000;
+  constexpr int N = 1000;
+  interflop_prism_set_seed(seed);
+
+  std::vector<uint64_t> got(2 * N);
+  std::thread worker([&got] {
+    rng::random(); // on the automatic stream first
+    interflop_prism_bind_rng_stream(stream);
+    for (int i = 0; i < N; ++i)
+      got[i] = rng::random();
+    interflop_prism_bind_rng_stream(stream);
+    for (int i = N; i < 2 * N; ++i)
+      got[i] = rng::random();
+  });
+  worker.join();
+
+  rng::internal::RNG reference{seed, stream};
+  for (int i = 0; i < 2 * N; ++i) {
+    EXPECT_EQ(got[i], reference()) << "draw " << i;
+  }
+}
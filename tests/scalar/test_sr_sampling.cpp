@@ -0,0 +1,140 @@
+// Antithetic and QMC sampling correlate the SR samples of repeated runs. A run
+// is modelled here by re-seeding the current thread's stream with the stream
+// seed of the run, which is what a fresh process does on its first draw.
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "hwy/highway.h"
+
+#include "src/prism_api.h"
+#include "src/sr_scalar-inl.h"
+#include "src/utils.h"
+#include "src/xoshiro.h"
+
+namespace rng = prism::scalar::xoshiro::HWY_NAMESPACE;
+namespace sr = prism::sr::scalar::HWY_NAMESPACE;
+
+namespace {
+
+constexpr uint64_t kSeed = 0x5EEDULL;
+constexpr int kOps = 1000;
+
+// Rounds 1 + b kOps times in the given run and records which results were
+// rounded up.
+template <typename T>
+auto RunOps(int32_t sampling, uint64_t run, T b) -> std::vector<bool> {
+  interflop_prism_set_sr_sampling(sampling, run);
+  rng::internal::init_rng(get_stream_seed(), 0);
+  std::vector<bool> up(kOps);
+  for (int i = 0; i < kOps; ++i) {
+    up[i] = sr::add(T{1}, b) > T{1};
+  }
+  return up;
+}
+
+class SRSamplingTest : public ::testing::Test {
+protected:
+  void SetUp() override { interflop_prism_set_seed(kSeed); }
+
+  void TearDown() override {
+    interflop_prism_set_sr_sampling(INTERFLOP_PRISM_SAMPLING_MC, 0);
+  }
+};
+
+TEST_F(SRSamplingTest, GetSetRoundtrip) {
+  interflop_prism_set_sr_sampling(INTERFLOP_PRISM_SAMPLING_QMC, 5);
+  EXPECT_EQ(interflop_prism_get_sr_sampling(), INTERFLOP_PRISM_SAMPLING_QMC);
+  EXPECT_EQ(interflop_prism_get_sr_run(), 5ULL);
+}
+
+// A thread that already drew restarts on its stream of the new scheme.
+TEST_F(SRSamplingTest, SettingTheSchemeReseedsRunningThreads) {
+  rng::random();
+  interflop_prism_set_sr_sampling(INTERFLOP_PRISM_SAMPLING_QMC, 3);
+  rng::internal::RNG reference{get_stream_seed(), get_stream_index()};
+  for (int i = 0; i < kOps; ++i) {
+    EXPECT_EQ(rng::random(), reference()) << "draw " << i;
+  }
+}
+
+TEST_F(SRSamplingTest, MonteCarloIgnoresTheRun) {
+  const float b = 0x1p-25F; // ulp(1) / 4
+  EXPECT_EQ(RunOps(INTERFLOP_PRISM_SAMPLING_MC, 0, b),
+            RunOps(INTERFLOP_PRISM_SAMPLING_MC, 5, b));
+}
+
+// 1 + ulp / 4 rounds up when z < 1 / 4: z and its mirror never both do.
+template <typename T> void CheckAntithetic(T b) {
+  for (uint64_t pair = 0; pair < 4; ++pair) {
+    const auto even = RunOps(INTERFLOP_PRISM_SAMPLING_ANTITHETIC, 2 * pair, b);
+    const auto odd =
+        RunOps(INTERFLOP_PRISM_SAMPLING_ANTITHETIC, 2 * pair + 1, b);
+    int ups = 0;
+    for (int i = 0; i < kOps; ++i) {
+      EXPECT_FALSE(even[i] && odd[i]) << "pair " << pair << ", op " << i;
+      ups += even[i] + odd[i];
+    }
+    EXPECT_GT(ups, 0);
+  }
+}
+
+TEST_F(SRSamplingTest, AntitheticPairsAreOpposite) {
+  CheckAntithetic(0x1p-25F);
+  CheckAntithetic(0x1p-54);
+}
+
+// The mirror of z = 0 is the largest sample of the grid below 1, not 1.
+template <typename T> void CheckAntitheticRange() {
+  const prism::sr::ConfigSnapshot config{
+      0, 0, 0, prism::sr::PRISM_SAMPLING_ANTITHETIC, UINT64_C(1) << 63};
+  const T last = prism::sr::apply_sampling(T{0}, config);
+  EXPECT_LT(last, T{1});
+  EXPECT_EQ(last, T{1} - std::numeric_limits<T>::epsilon());
+  EXPECT_EQ(prism::sr::apply_sampling(last, config), T{0});
+}
+
+TEST_F(SRSamplingTest, AntitheticSamplesStayBelowOne) {
+  CheckAntitheticRange<float>();
+  CheckAntitheticRange<double>();
+}
+
+// Pair k of seed S + 1 does not reuse the stream of pair k + 1 of seed S.
+TEST_F(SRSamplingTest, AdjacentSeedsDoNotSharePairs) {
+  for (uint64_t pair = 0; pair < 4; ++pair) {
+    interflop_prism_set_sr_sampling(INTERFLOP_PRISM_SAMPLING_ANTITHETIC,
+                                    2 * (pair + 1));
+    const uint64_t next_pair = prism::sr::stream_seed(kSeed);
+    interflop_prism_set_sr_sampling(INTERFLOP_PRISM_SAMPLING_ANTITHETIC,
+                                    2 * pair);
+    EXPECT_NE(prism::sr::stream_seed(kSeed + 1), next_pair) << "pair " << pair;
+    EXPECT_NE(prism::sr::stream_seed(kSeed ^ 1), next_pair) << "pair " << pair;
+  }
+}
+
+// Just below 1 + 3 ulp / 8, an op rounds up when z < 3 / 8. Runs 0 to 7 put
+// exactly one z in each eighth of [0, 1), so exactly 3 of them round up.
+template <typename T> void CheckQMC(T three_eighths_ulp) {
+  const T b = std::nextafter(three_eighths_ulp, T{0});
+  constexpr uint64_t kRuns = 8;
+  std::vector<int> ups(kOps, 0);
+  for (uint64_t run = 0; run < kRuns; ++run) {
+    const auto up = RunOps(INTERFLOP_PRISM_SAMPLING_QMC, run, b);
+    for (int i = 0; i < kOps; ++i) {
+      ups[i] += up[i];
+    }
+  }
+  for (int i = 0; i < kOps; ++i) {
+    EXPECT_EQ(ups[i], 3) << "op " << i;
+  }
+}
+
+TEST_F(SRSamplingTest, QMCRunsStratifyTheSample) {
+  CheckQMC(0x1.8p-25F);
+  CheckQMC(0x1.8p-54);
+}
+
+} // namespace
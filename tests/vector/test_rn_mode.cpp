@@ -1,11 +1,16 @@
 #include <cmath>
+#include <cstring>
+#include <random>
 #include <vector>
 #include <gtest/gtest.h>
 #include "src/prism_api.h"
+#include "src/sr_scalar.h"
 #include "src/sr_vector.h"
 #include "src/utils.h"
 
 namespace vrv = prism::sr::vector::dynamic_dispatch::variable;
+namespace vrf = prism::sr::vector::dynamic_dispatch::fixed;
+namespace srd = prism::sr::scalar::dynamic_dispatch;
 
 TEST(RNModeVectorTest, SpecialValues) {
   interflop_prism_set_rounding_mode(INTERFLOP_PRISM_RN);
@@ -167,3 +172,154 @@ TEST(RNModeVectorTest, SubnormalValues) {
   prism::sr::set_virtual_precision<double>(53);
   interflop_prism_set_rounding_mode(INTERFLOP_PRISM_SR);
 }
+
+// Bitwise comparison, so that NaNs and the sign of zero are checked too.
+template <typename T> auto SameBits(const T x, const T y) -> bool {
+  return std::memcmp(&x, &y, sizeof(T)) == 0;
+}
+
+template <typename T> auto RandomOperands(std::mt19937 &gen, size_t count) {
+  std::uniform_real_distribution<T> mantissa(T{1}, T{2});
+  std::uniform_int_distribution<int> exponent(-20, 20);
+  std::bernoulli_distribution negative(0.5);
+  std::vector<T> x(count);
+  for (auto &v : x) {
+    v = std::ldexp(mantissa(gen), exponent(gen));
+    v = negative(gen) ? -v : v;
+  }
+  return x;
+}
+
+TEST(RNModeVectorTest, HardwarePrecisionIsNative) {
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_RN);
+  prism::sr::set_virtual_precision<float>(24);
+
+  constexpr size_t count = 1001;
+  std::mt19937 gen(42);
+  auto a = RandomOperands<float>(gen, count);
+  auto b = RandomOperands<float>(gen, count);
+  const auto c = RandomOperands<float>(gen, count);
+  // Ties at binary32 precision round to even, as the hardware does
+  a[0] = 1.0f;
+  b[0] = std::ldexp(1.0f, -24);
+  a[1] = 1.0f + std::ldexp(1.0f, -23);
+  b[1] = std::ldexp(1.0f, -24);
+  std::vector<float> res(count);
+
+  vrv::addf32(a.data(), b.data(), res.data(), count);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_TRUE(SameBits(res[i], a[i] + b[i])) << i;
+    EXPECT_TRUE(SameBits(srd::addf32(a[i], b[i]), a[i] + b[i])) << i;
+  }
+  EXPECT_EQ(res[0], 1.0f);
+  EXPECT_EQ(res[1], 1.0f + std::ldexp(1.0f, -22));
+
+  vrv::mulf32(a.data(), b.data(), res.data(), count);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_TRUE(SameBits(res[i], a[i] * b[i])) << i;
+  }
+  vrv::divf32(a.data(), b.data(), res.data(), count);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_TRUE(SameBits(res[i], a[i] / b[i])) << i;
+  }
+  vrv::fmaf32(a.data(), b.data(), c.data(), res.data(), count);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_TRUE(SameBits(res[i], std::fma(a[i], b[i], c[i]))) << i;
+  }
+
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_SR);
+}
+
+// The scalar, array and fixed-size APIs run the same RN kernels: they must
+// agree bit for bit, at a specialized precision (11) and at runtime ones.
+TEST(RNModeVectorTest, ScalarArrayAndFixedAgree) {
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_RN);
+
+  constexpr size_t count = 64;
+  std::mt19937 gen(7);
+  const auto a_f = RandomOperands<float>(gen, count);
+  const auto b_f = RandomOperands<float>(gen, count);
+  const auto c_f = RandomOperands<float>(gen, count);
+  const auto a_d = RandomOperands<double>(gen, count);
+  const auto b_d = RandomOperands<double>(gen, count);
+  auto c_d = RandomOperands<double>(gen, count);
+  for (auto &v : c_d) {
+    v = std::fabs(v);
+  }
+  std::vector<float> res_f(count);
+  std::vector<double> res_d(count);
+
+  for (const int t : {11, 17}) {
+    prism::sr::set_virtual_precision<float>(t);
+
+    vrv::addf32(a_f.data(), b_f.data(), res_f.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_f[i], srd::addf32(a_f[i], b_f[i]))) << i;
+    }
+    vrv::subf32(a_f.data(), b_f.data(), res_f.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_f[i], srd::subf32(a_f[i], b_f[i]))) << i;
+    }
+    vrv::mulf32(a_f.data(), b_f.data(), res_f.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_f[i], srd::mulf32(a_f[i], b_f[i]))) << i;
+    }
+    vrv::divf32(a_f.data(), b_f.data(), res_f.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_f[i], srd::divf32(a_f[i], b_f[i]))) << i;
+    }
+    vrv::fmaf32(a_f.data(), b_f.data(), c_f.data(), res_f.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(
+          SameBits(res_f[i], srd::fmaf32(a_f[i], b_f[i], c_f[i])))
+          << i;
+    }
+
+    const vrf::f32x4_v a4 = {a_f[0], a_f[1], a_f[2], a_f[3]};
+    const vrf::f32x4_v b4 = {b_f[0], b_f[1], b_f[2], b_f[3]};
+    const auto sum4 = vrf::addf32x4(a4, b4);
+    const auto prod4 = vrf::mulf32x4(a4, b4);
+    for (size_t i = 0; i < 4; ++i) {
+      EXPECT_TRUE(SameBits(sum4[i], srd::addf32(a_f[i], b_f[i]))) << i;
+      EXPECT_TRUE(SameBits(prod4[i], srd::mulf32(a_f[i], b_f[i]))) << i;
+    }
+  }
+
+  for (const int t : {11, 30}) {
+    prism::sr::set_virtual_precision<double>(t);
+
+    vrv::addf64(a_d.data(), b_d.data(), res_d.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_d[i], srd::addf64(a_d[i], b_d[i]))) << i;
+    }
+    vrv::mulf64(a_d.data(), b_d.data(), res_d.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_d[i], srd::mulf64(a_d[i], b_d[i]))) << i;
+    }
+    vrv::divf64(a_d.data(), b_d.data(), res_d.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_d[i], srd::divf64(a_d[i], b_d[i]))) << i;
+    }
+    vrv::sqrtf64(c_d.data(), res_d.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(SameBits(res_d[i], srd::sqrtf64(c_d[i]))) << i;
+    }
+    vrv::fmaf64(a_d.data(), b_d.data(), c_d.data(), res_d.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_TRUE(
+          SameBits(res_d[i], srd::fmaf64(a_d[i], b_d[i], c_d[i])))
+          << i;
+    }
+
+    const vrf::f64x2_v a2 = {a_d[0], a_d[1]};
+    const vrf::f64x2_v b2 = {b_d[0], b_d[1]};
+    const auto quot2 = vrf::divf64x2(a2, b2);
+    for (size_t i = 0; i < 2; ++i) {
+      EXPECT_TRUE(SameBits(quot2[i], srd::divf64(a_d[i], b_d[i]))) << i;
+    }
+  }
+
+  prism::sr::set_virtual_precision<float>(24);
+  prism::sr::set_virtual_precision<double>(53);
+  interflop_prism_set_rounding_mode(INTERFLOP_PRISM_SR);
+}
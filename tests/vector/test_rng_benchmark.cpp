@@ -0,0 +1,326 @@
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// clang-format off
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "tests/vector/test_rng_benchmark.cpp"  // NOLINT
+#include "hwy/foreach_target.h"  // NOLINT IWYU pragma: keep
+#include "hwy/highway.h"
+#include "hwy/tests/test_util-inl.h"
+#include "hwy/timer.h"
+// clang-format on
+
+#include "src/random-inl.h"
+#include "src/xoshiro.h"
+
+/* Throughput of the random number generators, per dispatch target.
+ * Rates are given in random bits delivered per cycle and in GB/s. Cycles are
+ * counted with the invariant timestamp counter, i.e. at the nominal
+ * frequency. The bits delivered by an entry point are the random bits of its
+ * result: 64 for a word, 52 for a binary64 uniform, 23 for a binary32 uniform
+ * and 1 per lane for randombit(). Latencies (thread start with the state
+ * pool, jump ahead, scalar cache refills and capacity) are given in
+ * wall-clock time. */
+
+HWY_BEFORE_NAMESPACE();
+namespace hwy {
+namespace HWY_NAMESPACE { // required: unique per target
+namespace {
+
+namespace rng_vector = prism::vector::xoshiro::HWY_NAMESPACE;
+namespace rng_scalar = prism::scalar::xoshiro::HWY_NAMESPACE;
+
+constexpr std::uint64_t u64{};
+constexpr std::size_t kFill = 4096;
+constexpr std::size_t kFillRepetitions = 1UL << 12;
+constexpr std::size_t kCalls = 1UL << 24;
+
+std::uint64_t GetSeed() { return static_cast<uint64_t>(std::time(nullptr)); }
+
+// Runs func once to warm up, then times a second run. func returns a value
+// depending on every result so that the loop is not optimized out.
+template <class Func>
+void Report(const char *name, const double bits, const Func &func) {
+  std::uint64_t sink = func();
+  const auto start_time = std::chrono::steady_clock::now();
+  const timer::Ticks start = timer::Start();
+  sink ^= func();
+  const timer::Ticks stop = timer::Stop();
+  const auto end_time = std::chrono::steady_clock::now();
+  const std::chrono::duration<double, std::nano> diff = end_time - start_time;
+  fprintf(stderr, "[%s] %-26s: %7.3f bits/cycle, %7.3f GB/s (%llx)\n",
+          hwy::TargetName(HWY_TARGET), name,
+          bits / static_cast<double>(stop - start),
+          bits / 8.0 / diff.count(), static_cast<unsigned long long>(sink));
+}
+
+template <class Generator>
+void BenchEngine(const char *name, Generator &generator) {
+  const auto buffer = AllocateAligned<std::uint64_t>(kFill);
+  Report(name, 64.0 * kFill * kFillRepetitions, [&]() {
+    std::uint64_t sink = 0;
+    for (std::size_t i = 0; i < kFillRepetitions; ++i) {
+      generator.fill(buffer.get(), kFill);
+      sink ^= buffer[i % kFill];
+    }
+    return sink;
+  });
+}
+
+// Folds the lanes of a vector result into a scalar sink at the end of the
+// loop, so that the sink does not add a dependency per call.
+template <typename T, class Func>
+void BenchVectorAPI(const char *name, const double bits_per_lane,
+                    const Func &func) {
+  const ScalableTag<T> d;
+  const RebindToUnsigned<decltype(d)> du;
+  Report(name, bits_per_lane * kCalls * Lanes(d), [&]() {
+    auto acc = Zero(du);
+    for (std::size_t i = 0; i < kCalls; ++i) {
+      acc = Xor(acc, BitCast(du, func()));
+    }
+    return static_cast<std::uint64_t>(GetLane(acc));
+  });
+}
+
+template <typename T, class Func>
+void BenchScalarAPI(const char *name, const double bits, const Func &func) {
+  Report(name, bits * kCalls, [&]() {
+    std::uint64_t sink = 0;
+    for (std::size_t i = 0; i < kCalls; ++i) {
+      sink ^= BitCastScalar<MakeUnsigned<T>>(func());
+    }
+    return sink;
+  });
+}
+
+void TestEngineBitRate() {
+  const std::uint64_t seed = GetSeed();
+  VectorXoshiro xoshiro{seed};
+  VectorPhilox philox{seed};
+  BenchEngine("VectorXoshiro::fill", xoshiro);
+  BenchEngine("VectorPhilox::fill", philox);
+#if HWY_TARGET != HWY_SCALAR
+  VectorAES aes{seed};
+  BenchEngine("VectorAES::fill", aes);
+#endif
+
+  CachedXoshiro<> cached{seed};
+  BenchScalarAPI<std::uint64_t>("CachedXoshiro()", 64.0,
+                                [&]() { return cached(); });
+}
+
+void TestScalarAPIBitRate() {
+  rng_scalar::internal::init_rng(GetSeed(), 0);
+  BenchScalarAPI<std::uint64_t>("scalar random()", 64.0,
+                                []() { return rng_scalar::random(); });
+  BenchScalarAPI<float>("scalar uniform(float)", 23.0,
+                        []() { return rng_scalar::uniform(float{}); });
+  BenchScalarAPI<double>("scalar uniform(double)", 52.0,
+                         []() { return rng_scalar::uniform(double{}); });
+  BenchScalarAPI<std::uint64_t>("scalar randombit()", 1.0, []() {
+    return rng_scalar::randombit(u64);
+  });
+}
+
+void TestVectorAPIBitRate() {
+  rng_vector::internal::init_rng(GetSeed(), 0);
+  BenchVectorAPI<std::uint64_t>("vector random(u64)", 64.0, []() {
+    return rng_vector::random(u64);
+  });
+  BenchVectorAPI<float>("vector uniform(float)", 23.0,
+                        []() { return rng_vector::uniform(float{}); });
+#if HWY_HAVE_FLOAT64
+  BenchVectorAPI<double>("vector uniform(double)", 52.0,
+                         []() { return rng_vector::uniform(double{}); });
+#endif
+  BenchVectorAPI<std::uint64_t>("vector randombit(u64)", 1.0, []() {
+    return rng_vector::randombit(u64);
+  });
+}
+
+// Single-vector uniforms drawn from the generator directly and through the
+// per-thread ring that the SR round() and the fixed-size kernels consume.
+void TestUniformRingBitRate() {
+  rng_vector::internal::init_rng(GetSeed(), 0);
+  auto generator = rng_vector::internal::get_rng();
+  BenchVectorAPI<float>("direct uniform(float)", 23.0,
+                        [&]() { return generator->Uniform(float{}); });
+  BenchVectorAPI<float>("ring uniform(float)", 23.0,
+                        []() { return rng_vector::uniform(float{}); });
+#if HWY_HAVE_FLOAT64
+  BenchVectorAPI<double>("direct uniform(double)", 52.0,
+                         [&]() { return generator->Uniform(double{}); });
+  BenchVectorAPI<double>("ring uniform(double)", 52.0,
+                         []() { return rng_vector::uniform(double{}); });
+#endif
+}
+
+// Thread start cost with and without a state to adopt.
+void TestStatePoolLatency() {
+  constexpr std::size_t threads = 256;
+  const std::uint64_t user_seed = get_user_seed();
+  set_user_seed(GetSeed() ^ std::random_device()());
+  const std::uint64_t hits = prism::state_pool::hits.load();
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (std::size_t i = 0; i < threads; ++i) {
+    std::thread([] { rng_scalar::random(); }).join();
+  }
+  const auto end = std::chrono::high_resolution_clock::now();
+  const std::chrono::duration<double, std::micro> diff = end - start;
+  fprintf(stderr, "[%s] thread start + first draw: %.3f us, %llu/%zu adopted\n",
+          hwy::TargetName(HWY_TARGET), diff.count() / threads,
+          static_cast<unsigned long long>(prism::state_pool::hits.load() -
+                                          hits),
+          threads);
+  set_user_seed(user_seed);
+}
+
+// Per-op latency and cache footprint per thread against the cache capacity,
+// with many threads drawing at once. Threads with few draws keep the initial
+// cache size.
+void TestCacheSizeBenchmark() {
+  const char *env_threads = getenv("PRISM_TEST_THREADS");
+  const std::size_t threads =
+      env_threads != nullptr ? std::stoul(env_threads) : 64;
+  const std::uint64_t default_size = prism::rng_cache::get_cache_size();
+  const std::uint64_t user_seed = get_user_seed();
+  for (const std::size_t draws : {std::size_t{256}, std::size_t{1} << 18}) {
+    for (const std::uint64_t words :
+         {UINT64_C(256), UINT64_C(1024), UINT64_C(4096), UINT64_C(8192),
+          UINT64_C(65536)}) {
+      prism::rng_cache::set_cache_size(words);
+      // Fresh seed: no state from a previous size can be adopted.
+      set_user_seed(GetSeed() ^ std::random_device()());
+      std::vector<double> ns(threads);
+      std::vector<std::size_t> bytes(threads);
+      std::vector<std::thread> workers;
+      for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+          double sum = 0.0;
+          const auto start = std::chrono::high_resolution_clock::now();
+          for (std::size_t i = 0; i < draws; ++i) {
+            sum += rng_scalar::uniform(double{});
+          }
+          const auto end = std::chrono::high_resolution_clock::now();
+          const std::chrono::duration<double, std::nano> diff = end - start;
+          ns[t] = diff.count() / draws;
+          bytes[t] = rng_scalar::internal::get_rng()->Size() *
+                     sizeof(std::uint64_t);
+          HWY_ASSERT(sum >= 0.0);
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      double mean_ns = 0.0;
+      double mean_bytes = 0.0;
+      for (std::size_t t = 0; t < threads; ++t) {
+        mean_ns += ns[t] / threads;
+        mean_bytes += static_cast<double>(bytes[t]) / threads;
+      }
+      fprintf(stderr,
+              "[%s] %zu threads x %7zu draws, capacity %6llu words: "
+              "%.3f ns/op, cache %.1f KiB/thread\n",
+              hwy::TargetName(HWY_TARGET), threads, draws,
+              static_cast<unsigned long long>(words), mean_ns,
+              mean_bytes / 1024);
+    }
+  }
+  prism::rng_cache::set_cache_size(default_size);
+  set_user_seed(user_seed);
+}
+
+// Thread-start latency: time to construct the generator of thread tid.
+void TestJumpAheadLatency() {
+  const std::uint64_t seed = GetSeed();
+  constexpr std::size_t repetitions = 100;
+  for (const std::uint64_t tid :
+       {UINT64_C(0), UINT64_C(1), UINT64_C(16), UINT64_C(256), UINT64_C(4096),
+        UINT64_C(1) << 20, UINT64_C(1) << 40, ~UINT64_C(0)}) {
+    std::uint64_t sink = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < repetitions; ++i) {
+      VectorXoshiro generator{seed, tid};
+      sink ^= generator.GetState()[{0}][0];
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double, std::micro> diff = end - start;
+    fprintf(stderr, "[%s] VectorXoshiro(seed, %20llu): %.3f us (%llx)\n",
+            hwy::TargetName(HWY_TARGET), static_cast<unsigned long long>(tid),
+            diff.count() / repetitions, static_cast<unsigned long long>(sink));
+  }
+}
+
+// Per-draw latency distribution, whole-cache refill against slice refill.
+void TestCachedXorshiroLatency() {
+  const std::uint64_t seed = GetSeed();
+  constexpr std::size_t draws = 1UL << 20;
+  constexpr std::size_t capacity = 8192;
+  std::vector<double> ns(draws);
+  for (const std::size_t slice : {std::size_t{0}, kCachedXoshiroSliceSize}) {
+    CachedXoshiro<> generator{seed, 0, capacity, slice};
+    // Warm up until the cache has reached its capacity.
+    for (std::size_t i = 0; i < 4 * capacity; ++i) {
+      generator();
+    }
+    std::uint64_t sink = 0;
+    for (std::size_t i = 0; i < draws; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      sink ^= generator();
+      const auto end = std::chrono::steady_clock::now();
+      ns[i] = std::chrono::duration<double, std::nano>(end - start).count();
+    }
+    std::sort(ns.begin(), ns.end());
+    const auto percentile = [&](const double p) {
+      return ns[static_cast<std::size_t>(p * (draws - 1))];
+    };
+    fprintf(stderr,
+            "[%s] CachedXoshiro slice %4zu: p50 %.1f ns, p99 %.1f ns, "
+            "p99.9 %.1f ns, p99.99 %.1f ns, max %.1f ns (%llx)\n",
+            hwy::TargetName(HWY_TARGET), slice, percentile(0.5),
+            percentile(0.99), percentile(0.999), percentile(0.9999),
+            ns.back(), static_cast<unsigned long long>(sink));
+  }
+}
+
+} // namespace
+// NOLINTNEXTLINE(google-readability-namespace-comments)
+} // namespace HWY_NAMESPACE
+} // namespace hwy
+HWY_AFTER_NAMESPACE(); // required if not using HWY_ATTR
+
+#if HWY_ONCE
+namespace hwy {
+namespace {
+// NOLINTBEGIN
+HWY_BEFORE_TEST(PRISMRngBenchmark);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestEngineBitRate);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestScalarAPIBitRate);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestVectorAPIBitRate);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestUniformRingBitRate);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestStatePoolLatency);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestCacheSizeBenchmark);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestJumpAheadLatency);
+HWY_EXPORT_AND_TEST_P(PRISMRngBenchmark, TestCachedXorshiroLatency);
+// NOLINTEND
+HWY_AFTER_TEST();
+} // namespace
+} // namespace hwy
+HWY_TEST_MAIN();
+#endif // HWY_ONCE
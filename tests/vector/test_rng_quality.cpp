@@ -0,0 +1,330 @@
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream> // cerr
+#include <vector>
+
+#include <boost/math/distributions/chi_squared.hpp>
+#include <boost/math/distributions/poisson.hpp>
+
+// clang-format off
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "tests/vector/test_rng_quality.cpp"  // NOLINT
+#include "hwy/foreach_target.h"  // NOLINT IWYU pragma: keep
+#include "hwy/highway.h"
+#include "hwy/tests/test_util-inl.h"
+// clang-format on
+
+#include "src/random-inl.h"
+#include "src/xoshiro.h"
+
+/* In-process statistical battery for the random number generators.
+ * Each generator is read as a stream of 64-bit words, chunk by chunk, and the
+ * statistics are accumulated on the fly so that the stream can be several GB
+ * long. Its length in MiB is read from PRISM_RNG_QUALITY_MB (1024 by
+ * default).
+ * - frequency: number of ones of each of the 64 bit positions;
+ * - serial correlation: between the words at distance 1 to kMaxLag. For the
+ *   vector engines the words of one vector come from distinct lanes, so this
+ *   covers the correlation between lanes and along each lane;
+ * - gap: lengths of the gaps between the nibbles equal to zero, chi-square
+ *   against the geometric distribution;
+ * - birthday spacings: number of repeated spacings among kBirthdays 32-bit
+ *   values, for the low and the high half of the words, against Poisson.
+ * The thresholds are set for a false alarm rate below 1e-8 per statistic. */
+
+HWY_BEFORE_NAMESPACE();
+namespace hwy {
+namespace HWY_NAMESPACE { // required: unique per target
+namespace {
+
+namespace rng_vector = prism::vector::xoshiro::HWY_NAMESPACE;
+
+constexpr std::uint64_t u64{};
+constexpr std::size_t kChunk = 1UL << 16;
+constexpr std::size_t kDefaultStreamMiB = 1024;
+constexpr double kMaxZ = 6.0;
+constexpr double kMinPValue = 1e-9;
+
+constexpr std::size_t kMaxLag = 16;
+
+constexpr std::size_t kGapCategories = 64;
+constexpr double kGapProbability = 1.0 / 16.0;
+
+constexpr std::size_t kBirthdays = 4096;
+constexpr std::size_t kBirthdaySamples = 2048;
+// lambda = m^3 / (4 n) with m = kBirthdays and n = 2^32 days.
+constexpr double kBirthdayLambda = 4.0;
+
+std::uint64_t GetSeed() { return static_cast<uint64_t>(std::time(nullptr)); }
+
+auto GetStreamWords() -> std::size_t {
+  std::size_t mib = kDefaultStreamMiB;
+  if (const char *env = std::getenv("PRISM_RNG_QUALITY_MB")) {
+    const long long value = std::atoll(env);
+    if (value > 0) {
+      mib = static_cast<std::size_t>(value);
+    }
+  }
+  const std::size_t words = mib * (1UL << 20) / sizeof(std::uint64_t);
+  return HWY_MAX(words / kChunk, std::size_t{1}) * kChunk;
+}
+
+class Battery {
+public:
+  void Update(const std::uint64_t *HWY_RESTRICT words, const std::size_t n) {
+    Frequency(words, n);
+    Correlation(words, n);
+    Gap(words, n);
+    Birthday(words, n);
+    words_ += n;
+  }
+
+  // Returns false and prints the failing statistics if any.
+  auto Check(const char *name, const std::uint64_t seed) const -> bool {
+    bool ok = true;
+    const auto fail = [&](const char *test, const double value) {
+      std::cerr << "SEED: " << seed << std::endl;
+      std::cerr << "TEST " << name << " " << test << " FAILED: " << value
+                << std::endl;
+      ok = false;
+    };
+
+    const double n = static_cast<double>(words_);
+    double worst_bit = 0;
+    for (std::size_t bit = 0; bit < 64; ++bit) {
+      const double z = (2.0 * ones_[bit] - n) / std::sqrt(n);
+      worst_bit = std::max(worst_bit, std::abs(z));
+    }
+    if (worst_bit > kMaxZ) {
+      fail("frequency |z|", worst_bit);
+    }
+
+    double worst_lag = 0;
+    for (std::size_t lag = 1; lag <= kMaxLag; ++lag) {
+      // (u - 1/2)(v - 1/2) has variance 1/144 for independent uniforms.
+      const double z =
+          products_[lag - 1] * 12.0 / std::sqrt(static_cast<double>(pairs_));
+      worst_lag = std::max(worst_lag, std::abs(z));
+    }
+    if (worst_lag > kMaxZ) {
+      fail("serial correlation |z|", worst_lag);
+    }
+
+    double gaps = 0;
+    for (const std::uint64_t count : gaps_) {
+      gaps += static_cast<double>(count);
+    }
+    double chi2 = 0;
+    for (std::size_t k = 0; k <= kGapCategories; ++k) {
+      const double p =
+          k < kGapCategories
+              ? kGapProbability * std::pow(1.0 - kGapProbability, k)
+              : std::pow(1.0 - kGapProbability, kGapCategories);
+      const double expected = gaps * p;
+      const double delta = static_cast<double>(gaps_[k]) - expected;
+      chi2 += delta * delta / expected;
+    }
+    const boost::math::chi_squared_distribution<double> gap_law(
+        kGapCategories);
+    const double gap_p = boost::math::cdf(gap_law, chi2);
+    if (gap_p < kMinPValue || gap_p > 1.0 - kMinPValue) {
+      fail("gap chi-square p-value", gap_p);
+    }
+
+    if (birthday_samples_ > 0) {
+      const boost::math::poisson_distribution<double> birthday_law(
+          kBirthdayLambda * static_cast<double>(birthday_samples_));
+      for (std::size_t half = 0; half < 2; ++half) {
+        const double repeats = static_cast<double>(birthday_repeats_[half]);
+        const double below = boost::math::cdf(birthday_law, repeats);
+        const double above =
+            repeats > 0 ? boost::math::cdf(boost::math::complement(
+                              birthday_law, repeats - 1))
+                        : 1.0;
+        const double birthday_p = std::min(below, above);
+        if (birthday_p < kMinPValue) {
+          fail(half == 0 ? "birthday spacings (low half) p-value"
+                         : "birthday spacings (high half) p-value",
+               birthday_p);
+        }
+      }
+    }
+
+    fprintf(stderr,
+            "[%s] %-13s: %.2f GiB, frequency max|z| %.2f, correlation "
+            "max|z| %.2f, gap p %.4f, birthday repeats %llu/%llu (mean "
+            "%.0f)\n",
+            hwy::TargetName(HWY_TARGET), name,
+            n * sizeof(std::uint64_t) / (1UL << 30), worst_bit, worst_lag,
+            gap_p, static_cast<unsigned long long>(birthday_repeats_[0]),
+            static_cast<unsigned long long>(birthday_repeats_[1]),
+            kBirthdayLambda * static_cast<double>(birthday_samples_));
+    return ok;
+  }
+
+private:
+  std::uint64_t words_{};
+  std::array<std::uint64_t, 64> ones_{};
+  std::array<double, kMaxLag> products_{};
+  std::uint64_t pairs_{};
+  std::array<std::uint64_t, kGapCategories + 1> gaps_{};
+  std::size_t gap_{};
+  std::size_t birthday_samples_{};
+  std::array<std::uint64_t, 2> birthday_repeats_{};
+
+  // Vertical counters: byte b of counters[k] counts the ones of bit 8b+k.
+  // A byte can count up to 255 words before it is flushed.
+  void Frequency(const std::uint64_t *HWY_RESTRICT words, const std::size_t n) {
+    constexpr std::uint64_t kLowBits = 0x0101010101010101ULL;
+    for (std::size_t i = 0; i < n; i += 255) {
+      std::array<std::uint64_t, 8> counters{};
+      const std::size_t end = HWY_MIN(i + 255, n);
+      for (std::size_t j = i; j < end; ++j) {
+        for (std::size_t k = 0; k < 8; ++k) {
+          counters[k] += (words[j] >> k) & kLowBits;
+        }
+      }
+      for (std::size_t k = 0; k < 8; ++k) {
+        for (std::size_t b = 0; b < 8; ++b) {
+          ones_[8 * b + k] += (counters[k] >> (8 * b)) & 0xFF;
+        }
+      }
+    }
+  }
+
+  // Pairs are taken inside the chunk only.
+  void Correlation(const std::uint64_t *HWY_RESTRICT words,
+                   const std::size_t n) {
+    constexpr double kScale = 0x1.0p-53;
+    std::vector<double> centered(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      centered[i] = static_cast<double>(words[i] >> 11) * kScale - 0.5;
+    }
+    const std::size_t pairs = n - kMaxLag;
+    for (std::size_t lag = 1; lag <= kMaxLag; ++lag) {
+      double sum = 0;
+      for (std::size_t i = 0; i < pairs; ++i) {
+        sum += centered[i] * centered[i + lag];
+      }
+      products_[lag - 1] += sum;
+    }
+    pairs_ += pairs;
+  }
+
+  // Gaps run across word and chunk boundaries.
+  void Gap(const std::uint64_t *HWY_RESTRICT words, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::uint64_t word = words[i];
+      for (std::size_t nibble = 0; nibble < 16; ++nibble, word >>= 4) {
+        if ((word & 0xF) == 0) {
+          ++gaps_[HWY_MIN(gap_, kGapCategories)];
+          gap_ = 0;
+        } else {
+          ++gap_;
+        }
+      }
+    }
+  }
+
+  // Marsaglia's birthday spacings on the first kBirthdaySamples samples.
+  void Birthday(const std::uint64_t *HWY_RESTRICT words, const std::size_t n) {
+    std::vector<std::uint32_t> days(kBirthdays);
+    std::vector<std::uint32_t> spacings(kBirthdays);
+    for (std::size_t i = 0;
+         i + kBirthdays <= n && birthday_samples_ < kBirthdaySamples;
+         i += kBirthdays, ++birthday_samples_) {
+      for (std::size_t half = 0; half < 2; ++half) {
+        for (std::size_t j = 0; j < kBirthdays; ++j) {
+          days[j] = static_cast<std::uint32_t>(words[i + j] >> (32 * half));
+        }
+        std::sort(days.begin(), days.end());
+        spacings[0] = days[0];
+        for (std::size_t j = 1; j < kBirthdays; ++j) {
+          spacings[j] = days[j] - days[j - 1];
+        }
+        std::sort(spacings.begin(), spacings.end());
+        for (std::size_t j = 1; j < kBirthdays; ++j) {
+          birthday_repeats_[half] += spacings[j] == spacings[j - 1];
+        }
+      }
+    }
+  }
+};
+
+// fill(data, n) writes the next n words of the stream.
+template <class Fill>
+void RunBattery(const char *name, const std::uint64_t seed, const Fill &fill) {
+  const std::size_t words = GetStreamWords();
+  const auto buffer = AllocateAligned<std::uint64_t>(kChunk);
+  Battery battery;
+  for (std::size_t i = 0; i < words; i += kChunk) {
+    fill(buffer.get(), kChunk);
+    battery.Update(buffer.get(), kChunk);
+  }
+  HWY_ASSERT(battery.Check(name, seed));
+}
+
+template <class Generator> void RunEngineBattery(const char *name) {
+  const std::uint64_t seed = GetSeed();
+  Generator generator{seed};
+  RunBattery(name, seed, [&](std::uint64_t *data, const std::size_t n) {
+    generator.fill(data, n);
+  });
+}
+
+void TestXoshiroQuality() { RunEngineBattery<VectorXoshiro>("VectorXoshiro"); }
+
+void TestPhiloxQuality() { RunEngineBattery<VectorPhilox>("VectorPhilox"); }
+
+void TestAESQuality() {
+#if HWY_TARGET != HWY_SCALAR
+  RunEngineBattery<VectorAES>("VectorAES");
+#endif
+}
+
+// Stream seen by the vector API, through the per-thread ring.
+void TestVectorAPIQuality() {
+  const ScalableTag<std::uint64_t> d;
+  const std::uint64_t seed = GetSeed();
+  rng_vector::internal::init_rng(seed, 0);
+  RunBattery("vector random", seed,
+             [&](std::uint64_t *data, const std::size_t n) {
+               for (std::size_t i = 0; i < n; i += Lanes(d)) {
+                 Store(rng_vector::random(u64), d, data + i);
+               }
+             });
+}
+
+} // namespace
+// NOLINTNEXTLINE(google-readability-namespace-comments)
+} // namespace HWY_NAMESPACE
+} // namespace hwy
+HWY_AFTER_NAMESPACE(); // required if not using HWY_ATTR
+
+#if HWY_ONCE
+namespace hwy {
+namespace {
+// NOLINTBEGIN
+HWY_BEFORE_TEST(PRISMRngQualityTest);
+HWY_EXPORT_AND_TEST_P(PRISMRngQualityTest, TestXoshiroQuality);
+HWY_EXPORT_AND_TEST_P(PRISMRngQualityTest, TestPhiloxQuality);
+HWY_EXPORT_AND_TEST_P(PRISMRngQualityTest, TestAESQuality);
+HWY_EXPORT_AND_TEST_P(PRISMRngQualityTest, TestVectorAPIQuality);
+// NOLINTEND
+HWY_AFTER_TEST();
+} // namespace
+} // namespace hwy
+HWY_TEST_MAIN();
+#endif // HWY_ONCE
@@ -2,6 +2,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <mutex>
+#include <typeinfo>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -17,6 +18,7 @@
 
 #include "src/debug_vector-inl.h"
 #include "src/sr_vector-inl.h"
+#include "src/sr_vector.h"
 
 #include "tests/helper/tests-inl.h"
 
@@ -408,6 +410,150 @@ HWY_NOINLINE void TestAllSubnormalAssertionsFma() {
   hn::ForFloat3264Types(hn::ForPartialVectors<TestSubnormalAssertionsFma>());
 }
 
+// Random-bit budget: with r random bits per lane, z only takes the 2^r
+// midpoints (2c + 1) / 2^(r + 1), so 1 + f * ulp rounds up with probability
+// p_r = #{c : (2c + 1) / 2^(r + 1) <= f} / 2^r instead of f. Measures the
+// empirical bias against f and checks the frequency against p_r.
+struct TestRandomBitsBias {
+  template <typename T, class D> void operator()(T /*unused*/, D d) {
+    constexpr int32_t precision = prism::utils::IEEE754<T>::precision;
+    constexpr std::size_t samples = 1 << 17;
+    const std::size_t lanes = hn::Lanes(d);
+    const T ulp = std::ldexp(T{1}, -(precision - 1));
+    const T fraction = T{1} / T{3};
+    const double f = static_cast<double>(fraction);
+
+    prism::sr::set_virtual_precision<T>(precision);
+    const auto a = hn::Set(d, T{1});
+    const auto b = hn::Set(d, fraction * ulp);
+    const auto up = hn::Set(d, T{1} + ulp);
+
+    for (const int32_t bits : {0, 4, 8, 16}) {
+      prism::sr::set_random_bits(bits);
+      std::size_t count_up = 0;
+      std::size_t count = 0;
+      for (; count < samples; count += lanes) {
+        count_up += hn::CountTrue(d, hn::Eq(sr::add(d, a, b), up));
+      }
+      const double p_hat = static_cast<double>(count_up) / count;
+
+      double p_model = f;
+      if (bits != prism::sr::PRISM_RANDOM_BITS_FULL) {
+        const std::uint64_t cells = UINT64_C(1) << bits;
+        std::uint64_t below = 0;
+        for (std::uint64_t c = 0; c < cells; ++c) {
+          below += std::ldexp(2.0 * c + 1.0, -(bits + 1)) <= f;
+        }
+        p_model = static_cast<double>(below) / cells;
+        // Midpoint sampling bounds the bias by half a cell.
+        HWY_ASSERT(std::abs(p_model - f) <= std::ldexp(1.0, -(bits + 1)));
+      }
+
+      const double sigma = std::sqrt(p_model * (1 - p_model) / count);
+      fprintf(stderr, "[%s] %s bits=%-2d p=%.6f bias=%+.3e model=%+.3e\n",
+              hwy::TargetName(HWY_TARGET), typeid(T).name(), bits, p_hat,
+              p_hat - f, p_model - f);
+      if (std::abs(p_hat - p_model) > 6 * sigma) {
+        fprintf(stderr, "frequency %.6f does not match model %.6f (6 sigma = "
+                "%.3e)\n", p_hat, p_model, 6 * sigma);
+        HWY_ASSERT(0);
+      }
+    }
+    prism::sr::set_random_bits(prism::sr::PRISM_RANDOM_BITS_FULL);
+  }
+};
+
+HWY_NOINLINE void TestAllRandomBitsBias() {
+  hn::ForFloat3264Types(hn::ForPartialVectors<TestRandomBitsBias>());
+}
+
+// Caller-supplied randomness: 1 + ulp/8 rounds up iff z <= 1/8, so a regular
+// grid of z in [0, 1) gives an exact count of round-ups.
+constexpr std::size_t kCallerGrid = 1 << 10;
+
+struct TestCallerRandomness {
+  template <typename T, class D> void operator()(T /*unused*/, D d) {
+    constexpr int32_t precision = prism::utils::IEEE754<T>::precision;
+    const std::size_t lanes = hn::Lanes(d);
+    const T ulp = std::ldexp(T{1}, -(precision - 1));
+
+    prism::sr::set_virtual_precision<T>(precision);
+    const auto a = hn::Set(d, T{1});
+    const auto b = hn::Set(d, ulp / 8);
+    const auto up = hn::Set(d, T{1} + ulp);
+
+    std::size_t count_up = 0;
+    for (std::size_t i = 0; i < kCallerGrid; ++i) {
+      const auto z = hn::Set(d, static_cast<T>(i) / kCallerGrid);
+      const auto r = sr::add(d, a, b, z);
+      // The same z gives the same result.
+      HWY_ASSERT(hn::AllTrue(d, hn::Eq(r, sr::add(d, a, b, z))));
+      count_up += hn::CountTrue(d, hn::Eq(r, up));
+    }
+    HWY_ASSERT_EQ(count_up, (kCallerGrid / 8 + 1) * lanes);
+  }
+};
+
+HWY_NOINLINE void TestAllCallerRandomness() {
+  hn::ForFloat3264Types(hn::ForPartialVectors<TestCallerRandomness>());
+}
+
+namespace variable = prism::sr::vector::PRISM_DISPATCH::variable;
+
+void AddRand(const float *a, const float *b, const float *z, float *r,
+             std::size_t n) {
+  variable::addf32_rand(a, b, z, r, n);
+}
+void AddRand(const double *a, const double *b, const double *z, double *r,
+             std::size_t n) {
+  variable::addf64_rand(a, b, z, r, n);
+}
+void AddRand(const float *a, const float *b, const uint32_t *z, float *r,
+             std::size_t n) {
+  variable::addf32_randbits(a, b, z, r, n);
+}
+void AddRand(const double *a, const double *b, const uint64_t *z, double *r,
+             std::size_t n) {
+  variable::addf64_randbits(a, b, z, r, n);
+}
+
+// Same count through the array entry points, with z given as values and as
+// random bits whose top bits encode the grid point.
+template <typename T, typename Z> void CheckCallerRandomnessArray() {
+  constexpr int32_t precision = prism::utils::IEEE754<T>::precision;
+  const T ulp = std::ldexp(T{1}, -(precision - 1));
+  prism::sr::set_virtual_precision<T>(precision);
+
+  auto a = hwy::AllocateAligned<T>(kCallerGrid);
+  auto b = hwy::AllocateAligned<T>(kCallerGrid);
+  auto z = hwy::AllocateAligned<Z>(kCallerGrid);
+  auto r = hwy::AllocateAligned<T>(kCallerGrid);
+  for (std::size_t i = 0; i < kCallerGrid; ++i) {
+    a[i] = T{1};
+    b[i] = ulp / 8;
+    if constexpr (std::is_floating_point_v<Z>) {
+      z[i] = static_cast<Z>(i) / kCallerGrid;
+    } else {
+      z[i] = static_cast<Z>(i) << (sizeof(Z) * 8 - 10);
+    }
+  }
+  // An odd count exercises the partial last vector.
+  AddRand(a.get(), b.get(), z.get(), r.get(), kCallerGrid - 1);
+  std::size_t count_up = 0;
+  for (std::size_t i = 0; i < kCallerGrid - 1; ++i) {
+    count_up += r[i] == T{1} + ulp;
+  }
+  HWY_ASSERT_EQ(count_up, kCallerGrid / 8 + 1);
+}
+
+HWY_NOINLINE void TestCallerRandomnessArray() {
+  static_assert(kCallerGrid == 1 << 10, "random bits encode a 10-bit grid");
+  CheckCallerRandomnessArray<float, float>();
+  CheckCallerRandomnessArray<float, uint32_t>();
+  CheckCallerRandomnessArray<double, double>();
+  CheckCallerRandomnessArray<double, uint64_t>();
+}
+
 } // namespace
 } // namespace prism::HWY_NAMESPACE
 HWY_AFTER_NAMESPACE();
@@ -459,6 +605,9 @@ HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllSubnormalAssertionsMul);
 HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllSubnormalAssertionsDiv);
 HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllSubnormalAssertionsSqrt);
 HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllSubnormalAssertionsFma);
+HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllRandomBitsBias);
+HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestAllCallerRandomness);
+HWY_EXPORT_AND_TEST_P(SRVectorAccuracyTest, TestCallerRandomnessArray);
 HWY_AFTER_TEST();
 // NOLINTEND
 } // namespace prism::HWY_NAMESPACE
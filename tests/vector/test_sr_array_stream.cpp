@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// clang-format off
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "tests/vector/test_sr_array_stream.cpp"
+#include "hwy/foreach_target.h"  // NOLINT IWYU pragma: keep
+
+#include "hwy/highway.h"
+#include "hwy/tests/test_util-inl.h"
+
+#include "src/prism_api.h"
+#include "src/sr_vector.h"
+#include "src/xoshiro.h"
+// clang-format on
+
+/* The SR array functions draw their samples straight from the thread's
+ * engine, one random vector per vector of results, with the engine state
+ * held in registers for the whole call. Rounding an array must then decide
+ * exactly as the uniforms fill_uniform draws from the same state, and leave
+ * the engine where fill_uniform leaves it. A vector whose results are all
+ * exact at the virtual precision is returned as is, without drawing its
+ * samples. Built with PRISM_DEBUG, so that this fast path is counted. */
+
+HWY_BEFORE_NAMESPACE();
+namespace prism::HWY_NAMESPACE {
+namespace {
+
+namespace variable = prism::sr::vector::PRISM_DISPATCH::variable;
+
+// Not a multiple of any vector length: exercises the partial last vector.
+constexpr std::size_t kCount = 1001;
+constexpr std::size_t kAfter = 64;
+constexpr uint64_t kSeed = 0x51DE5EEDULL;
+
+auto Save() -> std::vector<uint8_t> {
+  std::vector<uint8_t> snapshot(interflop_prism_get_rng_state_size());
+  const auto size = snapshot.size();
+  HWY_ASSERT_EQ(interflop_prism_save_rng_state(snapshot.data(), size), size);
+  return snapshot;
+}
+
+void Restore(const std::vector<uint8_t> &snapshot) {
+  HWY_ASSERT_EQ(
+      interflop_prism_restore_rng_state(snapshot.data(), snapshot.size()), 0);
+}
+
+// 1 + tau with tau below ulp(1): rounds up iff z * ulp(1) <= tau, which is
+// evaluated exactly (ulp(1) is a power of two).
+template <typename T, class Add>
+void CheckAdd(const char *name, const T tau, const T ulp, const Add &add) {
+  interflop_prism_set_seed(kSeed);
+  std::vector<uint64_t> warmup(7);
+  prism::rng_fill::fill(warmup.data(), warmup.size());
+
+  const std::vector<T> a(kCount, T{1});
+  const std::vector<T> b(kCount, tau);
+  std::vector<T> result(kCount);
+  std::vector<uint64_t> after(kAfter);
+
+  const auto snapshot = Save();
+  add(a.data(), b.data(), result.data(), kCount);
+  prism::rng_fill::fill(after.data(), kAfter);
+
+  Restore(snapshot);
+  std::vector<T> z(kCount);
+  prism::rng_fill::fill_uniform(z.data(), kCount);
+  std::vector<uint64_t> expected_after(kAfter);
+  prism::rng_fill::fill(expected_after.data(), kAfter);
+
+  std::size_t ups = 0;
+  for (std::size_t i = 0; i < kCount; ++i) {
+    const bool up = result[i] > T{1};
+    if (up != (z[i] * ulp <= tau)) {
+      fprintf(stderr, "[%s] %s: element %zu, z = %a\n",
+              hwy::TargetName(HWY_TARGET), name, i, static_cast<double>(z[i]));
+      HWY_ASSERT(0);
+    }
+    ups += up;
+  }
+  HWY_ASSERT(ups > 0 && ups < kCount);
+  HWY_ASSERT(after == expected_after);
+
+  // The state written back at the end of the call replays the same array.
+  Restore(snapshot);
+  std::vector<T> replay(kCount);
+  add(a.data(), b.data(), replay.data(), kCount);
+  HWY_ASSERT(replay == result);
+}
+
+HWY_NOINLINE void TestArrayDrawsMatchTheEngine() {
+  CheckAdd<float>("addf32", 0x1.555556p-25F, 0x1p-23F, variable::addf32);
+  CheckAdd<double>("addf64", 0x1.5555555555555p-54, 0x1p-52,
+                   variable::addf64);
+}
+
+// Integer-valued operands: their sums, differences and products are exact.
+template <typename T> auto Integers(const int offset) -> std::vector<T> {
+  std::vector<T> x(kCount);
+  for (std::size_t i = 0; i < kCount; ++i) {
+    x[i] = static_cast<T>(static_cast<int>(i % 97) - offset);
+  }
+  return x;
+}
+
+template <typename T, class Op, class Exact>
+void CheckExact(const char *name, const Op &op, const Exact &exact) {
+  const auto a = Integers<T>(40);
+  const auto b = Integers<T>(7);
+  std::vector<T> result(kCount);
+
+  const auto before = interflop_prism_get_sr_exact_vectors();
+  const auto snapshot = Save();
+  op(a.data(), b.data(), result.data(), kCount);
+  if (Save() != snapshot) {
+    fprintf(stderr, "[%s] %s: exact array drew SR samples\n",
+            hwy::TargetName(HWY_TARGET), name);
+    HWY_ASSERT(0);
+  }
+  HWY_ASSERT(interflop_prism_get_sr_exact_vectors() > before);
+
+  for (std::size_t i = 0; i < kCount; ++i) {
+    HWY_ASSERT_EQ(result[i], exact(a[i], b[i]));
+  }
+
+  // One inexact lane is enough to draw the samples of its vector.
+  auto inexact = b;
+  inexact[kCount / 2] = T{1} / T{3};
+  op(a.data(), inexact.data(), result.data(), kCount);
+  HWY_ASSERT(Save() != snapshot);
+}
+
+HWY_NOINLINE void TestExactArraysKeepTheEngine() {
+  CheckExact<float>("addf32", variable::addf32,
+                    [](float x, float y) { return x + y; });
+  CheckExact<float>("mulf32", variable::mulf32,
+                    [](float x, float y) { return x * y; });
+  CheckExact<double>("subf64", variable::subf64,
+                     [](double x, double y) { return x - y; });
+  CheckExact<double>("mulf64", variable::mulf64,
+                     [](double x, double y) { return x * y; });
+}
+
+} // namespace
+} // namespace prism::HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace prism::HWY_NAMESPACE {
+// NOLINTBEGIN
+HWY_BEFORE_TEST(SRArrayStreamTest);
+HWY_EXPORT_AND_TEST_P(SRArrayStreamTest, TestArrayDrawsMatchTheEngine);
+HWY_EXPORT_AND_TEST_P(SRArrayStreamTest, TestExactArraysKeepTheEngine);
+HWY_AFTER_TEST();
+// NOLINTEND
+} // namespace prism::HWY_NAMESPACE
+
+HWY_TEST_MAIN();
+
+#endif // HWY_ONCE
@@ -1,13 +1,18 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <numeric>
 #include <stddef.h>
 #include <stdio.h>
+#include <vector>
 
 #include "gtest/gtest.h"
 
 #include "hwy/tests/hwy_gtest.h"
 #include "hwy/tests/test_util-inl.h"
 
+#include "src/sr_vector-inl.h"
 #include "src/sr_vector.h"
 
 namespace prism::sr::vector::PRISM_DISPATCH {
@@ -203,6 +208,21 @@ define_array_test_bin(mul, f64);
 define_array_test_bin(div, f64);
 define_array_test_ter(fma, f64);
 
+/* Variable size functions with caller-supplied randomness: c holds z, so
+ * these measure the rounding cost without the generator */
+
+#define define_array_test_bin_rand(op, type)                                   \
+  void test_##op##type##_rand(const VecArg##type &a, const VecArg##type &b,    \
+                              const VecArg##type &z, const VecArg##type &r,    \
+                              const size_t count) {                            \
+    variable::op##type##_rand(a.get(), b.get(), z.get(), r.get(), count);      \
+  }
+
+define_array_test_bin_rand(add, f32);
+define_array_test_bin_rand(mul, f32);
+define_array_test_bin_rand(add, f64);
+define_array_test_bin_rand(mul, f64);
+
 /* Fixed size functions tests */
 
 #define define_vector_test_un(op, type, size)                                  \
@@ -367,6 +387,283 @@ TEST(SRArrayBenchmark, SRFmaF64) {
   callMeasureFunctions<2, size_max_test_array, double, 3>(&test_fmaf64);
 }
 
+/* Caller-supplied randomness */
+
+TEST(SRArrayBenchmark, SRAddF32Rand) {
+  constexpr size_t N = repetitions;
+  std::cout << "Measure function sr::addf32_rand with " << N
+            << " repetitions\n";
+  callMeasureFunctions<2, size_max_test_array, float, 3>(&test_addf32_rand);
+}
+
+TEST(SRArrayBenchmark, SRMulF32Rand) {
+  constexpr size_t N = repetitions;
+  std::cout << "Measure function sr::mulf32_rand with " << N
+            << " repetitions\n";
+  callMeasureFunctions<2, size_max_test_array, float, 3>(&test_mulf32_rand);
+}
+
+TEST(SRArrayBenchmark, SRAddF64Rand) {
+  constexpr size_t N = repetitions;
+  std::cout << "Measure function sr::addf64_rand with " << N
+            << " repetitions\n";
+  callMeasureFunctions<2, size_max_test_array, double, 3>(&test_addf64_rand);
+}
+
+TEST(SRArrayBenchmark, SRMulF64Rand) {
+  constexpr size_t N = repetitions;
+  std::cout << "Measure function sr::mulf64_rand with " << N
+            << " repetitions\n";
+  callMeasureFunctions<2, size_max_test_array, double, 3>(&test_mulf64_rand);
+}
+
+/* Vector round: ulp_t read from the bits of trunc, against the former
+ * get_exponent / pow2 chain with its thread-local exponent cache, at hardware
+ * and at reduced virtual precision. Both must give the same results. */
+
+namespace hn = hwy::HWY_NAMESPACE;
+namespace pr = prism::sr::vector::PRISM_DISPATCH::HWY_NAMESPACE;
+
+namespace legacy {
+
+template <class D, class V = hn::VFromD<D>, typename T = hn::TFromD<D>>
+auto round(const D d, const V sigma, const V tau, const V z,
+           const prism::sr::ConfigSnapshot &config) -> V {
+  using DI = hn::RebindToSigned<D>;
+  using VI = hn::VFromD<DI>;
+  const DI di{};
+  const int32_t t = config.virtual_precision;
+  const auto zero = hn::Zero(d);
+  const auto one = hn::Set(d, T{1});
+  const auto trunc = pr::truncate_mantissa(d, sigma, t);
+  const auto rho = hn::Sub(sigma, trunc);
+  const auto rho_is_zero = hn::Eq(rho, zero);
+  const auto both_zero = hn::And(rho_is_zero, hn::Eq(tau, zero));
+  const auto sign_delta =
+      hn::Or(hn::And(rho_is_zero, hn::Lt(tau, zero)),
+             hn::And(hn::Not(rho_is_zero), hn::Lt(rho, zero)));
+  const auto sign_dir = hn::IfThenElse(sign_delta, hn::Neg(one), one);
+  const auto sign_diff = hn::Xor(sign_delta, hn::Lt(trunc, zero));
+  const auto pred_trunc = pr::get_predecessor_abs(d, trunc);
+
+  thread_local static V last_trunc = hn::Zero(d);
+  thread_local static VI last_trunc_exp = hn::Zero(di);
+  thread_local static V last_pred_trunc = hn::Zero(d);
+  thread_local static VI last_pred_trunc_exp = hn::Zero(di);
+  if (!hn::AllTrue(d, hn::Eq(trunc, last_trunc))) {
+    last_trunc = trunc;
+    last_trunc_exp = pr::get_exponent(d, trunc);
+  }
+  if (!hn::AllTrue(d, hn::Eq(pred_trunc, last_pred_trunc))) {
+    last_pred_trunc = pred_trunc;
+    last_pred_trunc_exp = pr::get_exponent(d, pred_trunc);
+  }
+  const auto eta = hn::IfThenElse(hn::RebindMask(di, sign_diff),
+                                  last_pred_trunc_exp, last_trunc_exp);
+
+  const auto exp = hn::Sub(eta, hn::Set(di, t - 1));
+  const auto ulp_t = hn::Mul(sign_dir, pr::pow2(d, exp));
+  constexpr int32_t min_exp = prism::utils::IEEE754<T>::min_exponent;
+  const auto is_min_exp = hn::Le(exp, hn::Set(di, min_exp));
+  const auto scale = hn::IfThenElse(hn::RebindMask(d, is_min_exp),
+                                    hn::Set(d, prism::utils::pow2<T>(64)), one);
+  const auto pi = hn::Mul(hn::Mul(ulp_t, scale), z);
+  const auto D_val =
+      hn::Add(hn::Sub(hn::Mul(rho, scale), pi), hn::Mul(tau, scale));
+  const auto rnd =
+      hn::IfThenElseZero(hn::Ge(hn::Mul(D_val, sign_dir), zero), ulp_t);
+  return hn::IfThenElse(both_zero, trunc, hn::Add(trunc, rnd));
+}
+
+} // namespace legacy
+
+// Operands spread over several binades and signs, so that trunc changes from
+// one vector to the next.
+template <typename T> struct RoundInputs {
+  explicit RoundInputs(const size_t n)
+      : sigma(hwy::MakeUniqueAlignedArray<T>(n)),
+        tau(hwy::MakeUniqueAlignedArray<T>(n)),
+        z(hwy::MakeUniqueAlignedArray<T>(n)),
+        r(hwy::MakeUniqueAlignedArray<T>(n)) {
+    constexpr T ulp = std::is_same_v<T, float> ? 0x1.0p-24F : 0x1.0p-53;
+    for (size_t i = 0; i < n; i++) {
+      const T sign = (i % 3 == 0) ? T{-1} : T{1};
+      sigma[i] = sign * std::ldexp(T{1} + static_cast<T>(i) / T{7},
+                                   static_cast<int>(i % 17) - 8);
+      tau[i] = ((i % 2 == 0) ? ulp : -ulp) * static_cast<T>(i % 5) / T{3};
+      z[i] = static_cast<T>(i % 97) / T{97};
+    }
+  }
+  hwy::AlignedUniquePtr<T[]> sigma;
+  hwy::AlignedUniquePtr<T[]> tau;
+  hwy::AlignedUniquePtr<T[]> z;
+  hwy::AlignedUniquePtr<T[]> r;
+};
+
+// Rounds the inputs N times with round and returns the mean time per call.
+template <typename T, std::size_t N = repetitions / 10, class Round>
+auto MeasureRound(const char *name, const Round &round,
+                  RoundInputs<T> &inputs, const size_t n,
+                  const prism::sr::ConfigSnapshot &config) -> double {
+  const hn::ScalableTag<T> d;
+  const size_t lanes = hn::Lanes(d);
+  std::vector<double> times(N);
+  for (size_t k = 0; k < N; k++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i + lanes <= n; i += lanes) {
+      const auto sigma = hn::Load(d, inputs.sigma.get() + i);
+      const auto tau = hn::Load(d, inputs.tau.get() + i);
+      const auto z = hn::Load(d, inputs.z.get() + i);
+      hn::Store(round(d, sigma, tau, z, config), d, inputs.r.get() + i);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+    times[k] = diff.count();
+  }
+  auto min = *std::min_element(times.begin(), times.end());
+  auto max = *std::max_element(times.begin(), times.end());
+  auto mean = std::accumulate(times.begin(), times.end(), 0.0) / N;
+  fprintf(stderr, "[%-4zu] %-8s t=%-2d %.4e [%.4e - %.4e] (%zu)\n", n, name,
+          config.virtual_precision, mean, min, max, N);
+  return mean;
+}
+
+template <typename T> void CompareRound(const int32_t t) {
+  constexpr size_t n = size_max_test_array;
+  RoundInputs<T> inputs(n);
+  auto config = prism::sr::get_config_snapshot<T>();
+  config.virtual_precision = t;
+
+  const auto legacy_round = [](auto d, auto sigma, auto tau, auto z,
+                               const prism::sr::ConfigSnapshot &c) {
+    return legacy::round(d, sigma, tau, z, c);
+  };
+  const auto bit_round = [](auto d, auto sigma, auto tau, auto z,
+                            const prism::sr::ConfigSnapshot &c) {
+    return pr::round(d, sigma, tau, z, c);
+  };
+
+  const double before = MeasureRound<T>("legacy", legacy_round, inputs, n,
+                                        config);
+  std::vector<T> expected(inputs.r.get(), inputs.r.get() + n);
+  const double after = MeasureRound<T>("bits", bit_round, inputs, n, config);
+  fprintf(stderr, "speedup t=%d: %.2fx\n", t, before / after);
+
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(std::memcmp(&expected[i], &inputs.r[i], sizeof(T)), 0)
+        << "t=" << t << " element " << i;
+  }
+}
+
+TEST(SRRoundBenchmark, BitLevelUlpF32) {
+  CompareRound<float>(prism::utils::IEEE754<float>::precision);
+  CompareRound<float>(11);
+}
+
+TEST(SRRoundBenchmark, BitLevelUlpF64) {
+  CompareRound<double>(prism::utils::IEEE754<double>::precision);
+  CompareRound<double>(24);
+}
+
+/* Fixed-size kernels: the N elements in as few vectors as possible, one
+ * vector of samples each, against the former element-wise loop that
+ * broadcast every element and drew a whole vector of samples for one lane. */
+
+namespace legacy {
+
+template <typename T, std::size_t N, typename V, class Op>
+auto ElementWise(const V a, const V b, const Op &op) -> V {
+  const hn::ScalableTag<T> d;
+  V r;
+  for (size_t i = 0; i < N; i++) {
+    r[i] = hn::GetLane(op(d, hn::Set(d, a[i]), hn::Set(d, b[i])));
+  }
+  return r;
+}
+
+} // namespace legacy
+
+// Applies func to kBatch vectors of N elements, R times, and returns the mean
+// time per batch.
+template <typename T, std::size_t N, typename V,
+          std::size_t R = repetitions / 10, class Op>
+auto MeasureFixed(const char *name, const Op &func) -> double {
+  constexpr size_t kBatch = 256;
+  constexpr T ulp = std::is_same_v<T, float> ? 0x1.0p-24F : 0x1.0p-53;
+  std::vector<V> a(kBatch);
+  std::vector<V> b(kBatch);
+  std::vector<V> r(kBatch);
+  for (size_t k = 0; k < kBatch; k++) {
+    for (size_t i = 0; i < N; i++) {
+      a[k][i] = T{1} + static_cast<T>(k * N + i) / T{7};
+      b[k][i] = ulp * static_cast<T>((k + i) % 5) / T{3};
+    }
+  }
+  std::vector<double> times(R);
+  for (size_t n = 0; n < R; n++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t k = 0; k < kBatch; k++) {
+      r[k] = func(a[k], b[k]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+    times[n] = diff.count();
+  }
+  auto min = *std::min_element(times.begin(), times.end());
+  auto max = *std::max_element(times.begin(), times.end());
+  auto mean = std::accumulate(times.begin(), times.end(), 0.0) / R;
+  fprintf(stderr, "[x%-3zu] %-12s %.4e [%.4e - %.4e] (%zu)\n", N, name, mean,
+          min, max, R);
+  return mean;
+}
+
+template <typename T, std::size_t N, typename V, class Legacy, class Fixed>
+void CompareFixed(const char *name, const Legacy &legacy_op,
+                  const Fixed &fixed_op) {
+  const double before = MeasureFixed<T, N, V>(
+      "element", [&](const V a, const V b) {
+        return legacy::ElementWise<T, N>(a, b, legacy_op);
+      });
+  const double after = MeasureFixed<T, N, V>("vector", fixed_op);
+  fprintf(stderr, "%s speedup: %.2fx\n", name, before / after);
+}
+
+#if HWY_MAX_BYTES >= 16
+TEST(SRFixedBenchmark, AddF32x4) {
+  CompareFixed<float, 4, fixed::f32x4_v>(
+      "addf32x4", [](auto d, auto a, auto b) { return pr::add(d, a, b); },
+      [](const fixed::f32x4_v a, const fixed::f32x4_v b) {
+        return fixed::addf32x4(a, b);
+      });
+}
+
+TEST(SRFixedBenchmark, MulF32x4) {
+  CompareFixed<float, 4, fixed::f32x4_v>(
+      "mulf32x4", [](auto d, auto a, auto b) { return pr::mul(d, a, b); },
+      [](const fixed::f32x4_v a, const fixed::f32x4_v b) {
+        return fixed::mulf32x4(a, b);
+      });
+}
+
+TEST(SRFixedBenchmark, AddF64x2) {
+  CompareFixed<double, 2, fixed::f64x2_v>(
+      "addf64x2", [](auto d, auto a, auto b) { return pr::add(d, a, b); },
+      [](const fixed::f64x2_v a, const fixed::f64x2_v b) {
+        return fixed::addf64x2(a, b);
+      });
+}
+#endif
+
+#if HWY_MAX_BYTES >= 32
+TEST(SRFixedBenchmark, AddF32x8) {
+  CompareFixed<float, 8, fixed::f32x8_v>(
+      "addf32x8", [](auto d, auto a, auto b) { return pr::add(d, a, b); },
+      [](const fixed::f32x8_v a, const fixed::f32x8_v b) {
+        return fixed::addf32x8(a, b);
+      });
+}
+#endif
+
 constexpr auto kVerbose = false;
 
 /* Test on single vector passed by value with static dispatch */
@@ -0,0 +1,173 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// clang-format off
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "tests/vector/test_sr_precision.cpp"
+#include "hwy/foreach_target.h"  // NOLINT IWYU pragma: keep
+
+#include "hwy/highway.h"
+#include "hwy/tests/test_util-inl.h"
+
+#include "src/sr_vector-inl.h"
+// clang-format on
+
+/* The SR array kernels are instantiated for the common virtual precisions,
+ * with t a compile-time constant (see SpecializedPrecisions). Each
+ * instantiation must round exactly as the generic kernel, which reads t from
+ * the configuration, for the same operands and samples. */
+
+HWY_BEFORE_NAMESPACE();
+namespace prism::HWY_NAMESPACE {
+namespace {
+
+namespace hn = hwy::HWY_NAMESPACE;
+namespace pr = prism::sr::vector::PRISM_DISPATCH::HWY_NAMESPACE;
+
+constexpr std::size_t kCount = 4096;
+constexpr uint64_t kSeed = 0xC0FFEEULL;
+
+// Random operands over the whole exponent range, plus the special values.
+template <typename T> auto Operands(std::mt19937_64 &gen) -> std::vector<T> {
+  using Limits = std::numeric_limits<T>;
+  std::vector<T> x = {T{0},
+                      -T{0},
+                      T{1},
+                      Limits::min(),
+                      Limits::denorm_min(),
+                      Limits::max(),
+                      -Limits::max(),
+                      Limits::infinity(),
+                      -Limits::infinity(),
+                      Limits::quiet_NaN()};
+  std::uniform_real_distribution<T> mantissa(T{1}, T{2});
+  std::uniform_int_distribution<int> exponent(Limits::min_exponent - 8,
+                                              Limits::max_exponent - 1);
+  std::bernoulli_distribution negative(0.5);
+  while (x.size() < kCount) {
+    const T v = std::ldexp(mantissa(gen), exponent(gen));
+    x.push_back(negative(gen) ? -v : v);
+  }
+  return x;
+}
+
+template <typename T> auto Samples(std::mt19937_64 &gen) -> std::vector<T> {
+  std::uniform_real_distribution<T> uniform(T{0}, T{1});
+  std::vector<T> z(kCount);
+  for (auto &v : z) {
+    v = uniform(gen);
+  }
+  return z;
+}
+
+// Applies op(d, a, b, c, draw_z) to whole arrays, draw_z() returning the
+// samples of the vector.
+template <typename T, class Op>
+auto Apply(const std::vector<T> &a, const std::vector<T> &b,
+           const std::vector<T> &c, const std::vector<T> &z, const Op &op)
+    -> std::vector<T> {
+  const hn::ScalableTag<T> d;
+  const std::size_t N = hn::Lanes(d);
+  std::vector<T> result(kCount);
+  for (std::size_t i = 0; i < kCount; i += N) {
+    const std::size_t lanes = kCount - i < N ? kCount - i : N;
+    const auto draw_z = [&] { return hn::LoadN(d, z.data() + i, lanes); };
+    const auto res = op(d, hn::LoadN(d, a.data() + i, lanes),
+                        hn::LoadN(d, b.data() + i, lanes),
+                        hn::LoadN(d, c.data() + i, lanes), draw_z);
+    hn::StoreN(res, d, result.data() + i, lanes);
+  }
+  return result;
+}
+
+template <typename T>
+void ExpectSame(const char *op, const int32_t t, const std::vector<T> &got,
+                const std::vector<T> &expected) {
+  if (std::memcmp(got.data(), expected.data(), kCount * sizeof(T)) != 0) {
+    fprintf(stderr, "[%s] %s at t = %d differs from the generic kernel\n",
+            hwy::TargetName(HWY_TARGET), op, t);
+    HWY_ASSERT(0);
+  }
+}
+
+template <typename T, int32_t kPrecision> void CheckPrecision() {
+  std::mt19937_64 gen(kSeed + kPrecision);
+  const auto a = Operands<T>(gen);
+  const auto b = Operands<T>(gen);
+  const auto c = Operands<T>(gen);
+  const auto z = Samples<T>(gen);
+  auto config = prism::sr::get_config_snapshot<T>();
+  config.rounding_mode = prism::sr::PRISM_SR;
+  config.virtual_precision = kPrecision;
+
+  constexpr int32_t kRuntime = pr::kRuntimePrecision;
+  const auto check = [&](const char *name, const auto &op) {
+    const auto specialized = Apply(a, b, c, z, [&](auto d, auto va, auto vb,
+                                                   auto vc, auto draw_z) {
+      return op(std::integral_constant<int32_t, kPrecision>{}, d, va, vb, vc,
+                draw_z);
+    });
+    const auto generic = Apply(a, b, c, z, [&](auto d, auto va, auto vb,
+                                               auto vc, auto draw_z) {
+      return op(std::integral_constant<int32_t, kRuntime>{}, d, va, vb, vc,
+                draw_z);
+    });
+    ExpectSame(name, kPrecision, specialized, generic);
+  };
+
+  check("add", [&](auto p, auto d, auto va, auto vb, auto, auto draw_z) {
+    return pr::add<decltype(p)::value>(d, va, vb, draw_z, config);
+  });
+  check("sub", [&](auto p, auto d, auto va, auto vb, auto, auto draw_z) {
+    return pr::sub<decltype(p)::value>(d, va, vb, draw_z, config);
+  });
+  check("mul", [&](auto p, auto d, auto va, auto vb, auto, auto draw_z) {
+    return pr::mul<decltype(p)::value>(d, va, vb, draw_z, config);
+  });
+  check("div", [&](auto p, auto d, auto va, auto vb, auto, auto draw_z) {
+    return pr::div<decltype(p)::value>(d, va, vb, draw_z, config);
+  });
+  check("sqrt", [&](auto p, auto d, auto va, auto, auto, auto draw_z) {
+    return pr::sqrt<decltype(p)::value>(d, hn::Abs(va), draw_z, config);
+  });
+  check("fma", [&](auto p, auto d, auto va, auto vb, auto vc, auto draw_z) {
+    return pr::fma<decltype(p)::value>(d, va, vb, vc, draw_z, config);
+  });
+}
+
+HWY_NOINLINE void TestSpecializedMatchesGenericF32() {
+  CheckPrecision<float, 24>();
+  CheckPrecision<float, 11>();
+  CheckPrecision<float, 8>();
+}
+
+HWY_NOINLINE void TestSpecializedMatchesGenericF64() {
+  CheckPrecision<double, 53>();
+  CheckPrecision<double, 24>();
+  CheckPrecision<double, 11>();
+  CheckPrecision<double, 8>();
+}
+
+} // namespace
+} // namespace prism::HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace prism::HWY_NAMESPACE {
+// NOLINTBEGIN
+HWY_BEFORE_TEST(SRPrecisionTest);
+HWY_EXPORT_AND_TEST_P(SRPrecisionTest, TestSpecializedMatchesGenericF32);
+HWY_EXPORT_AND_TEST_P(SRPrecisionTest, TestSpecializedMatchesGenericF64);
+HWY_AFTER_TEST();
+// NOLINTEND
+} // namespace prism::HWY_NAMESPACE
+
+HWY_TEST_MAIN();
+
+#endif // HWY_ONCE
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// clang-format off
+#undef HWY_TARGET_INCLUDE
+#define HWY_TARGET_INCLUDE "tests/vector/test_sr_reproducible.cpp"
+#include "hwy/foreach_target.h"  // NOLINT IWYU pragma: keep
+
+#include "hwy/highway.h"
+#include "hwy/tests/test_util-inl.h"
+
+#include "src/prism_api.h"
+#include "src/sr_vector.h"
+// clang-format on
+
+/* Reproducible mode: with the same seed, the SR array functions give
+ * bit-identical results on every dispatch target. Each run of the test is
+ * dispatched to one target (the test parameter); the first one records the
+ * results and the others must match them. */
+
+HWY_BEFORE_NAMESPACE();
+namespace prism::HWY_NAMESPACE {
+namespace {
+
+namespace variable = prism::sr::vector::PRISM_DISPATCH::variable;
+
+// Not a multiple of any vector length: exercises the partial last vector.
+constexpr std::size_t kCount = 1001;
+constexpr uint64_t kSeed = 0x12345678ULL;
+
+std::vector<std::uint8_t> &Reference() {
+  static std::vector<std::uint8_t> reference;
+  return reference;
+}
+
+template <typename T> void Append(std::vector<std::uint8_t> &out, const T *r) {
+  const auto *bytes = reinterpret_cast<const std::uint8_t *>(r);
+  out.insert(out.end(), bytes, bytes + kCount * sizeof(T));
+}
+
+// Operands whose results are not representable, so that every element is
+// rounded with its own SR sample.
+template <typename T> auto Operands(const T offset) -> std::vector<T> {
+  std::vector<T> x(kCount);
+  for (std::size_t i = 0; i < kCount; ++i) {
+    x[i] = offset + static_cast<T>(i) / T{3};
+  }
+  return x;
+}
+
+void AppendF32(std::vector<std::uint8_t> &out) {
+  const auto a = Operands(1.0F);
+  const auto b = Operands(0.1F);
+  const auto c = Operands(-0.7F);
+  std::vector<float> r(kCount);
+  variable::addf32(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::mulf32(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::divf32(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::sqrtf32(a.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::fmaf32(a.data(), b.data(), c.data(), r.data(), kCount);
+  Append(out, r.data());
+}
+
+void AppendF64(std::vector<std::uint8_t> &out) {
+  const auto a = Operands(1.0);
+  const auto b = Operands(0.1);
+  const auto c = Operands(-0.7);
+  std::vector<double> r(kCount);
+  variable::addf64(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::subf64(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::mulf64(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::divf64(a.data(), b.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::sqrtf64(a.data(), r.data(), kCount);
+  Append(out, r.data());
+  variable::fmaf64(a.data(), b.data(), c.data(), r.data(), kCount);
+  Append(out, r.data());
+}
+
+HWY_NOINLINE void TestReproducibleAcrossTargets() {
+  interflop_prism_set_sr_reproducible(1);
+  // Reseeding restarts the call counter of the thread.
+  interflop_prism_set_seed(kSeed);
+  std::vector<std::uint8_t> results;
+  AppendF32(results);
+  AppendF64(results);
+  interflop_prism_set_sr_reproducible(0);
+
+  auto &reference = Reference();
+  if (reference.empty()) {
+    reference = results;
+    return;
+  }
+  HWY_ASSERT_EQ(results.size(), reference.size());
+  if (std::memcmp(results.data(), reference.data(), results.size()) != 0) {
+    fprintf(stderr, "[%s] SR results differ from the first target\n",
+            hwy::TargetName(HWY_TARGET));
+    HWY_ASSERT(0);
+  }
+}
+
+// The call counter gives every array op its own stream: two identical calls
+// do not round alike.
+HWY_NOINLINE void TestReproducibleCallsDiffer() {
+  interflop_prism_set_sr_reproducible(1);
+  interflop_prism_set_seed(kSeed);
+  std::vector<std::uint8_t> first;
+  std::vector<std::uint8_t> second;
+  AppendF32(first);
+  AppendF32(second);
+  interflop_prism_set_sr_reproducible(0);
+  HWY_ASSERT(first != second);
+}
+
+} // namespace
+} // namespace prism::HWY_NAMESPACE
+HWY_AFTER_NAMESPACE();
+
+#if HWY_ONCE
+namespace prism::HWY_NAMESPACE {
+// NOLINTBEGIN
+HWY_BEFORE_TEST(SRReproducibleTest);
+HWY_EXPORT_AND_TEST_P(SRReproducibleTest, TestReproducibleAcrossTargets);
+HWY_EXPORT_AND_TEST_P(SRReproducibleTest, TestReproducibleCallsDiffer);
+HWY_AFTER_TEST();
+// NOLINTEND
+} // namespace prism::HWY_NAMESPACE
+
+HWY_TEST_MAIN();
+
+#endif // HWY_ONCE
@@ -4,6 +4,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -454,6 +455,441 @@ void TestUniformCachedXorshiro() {
 #endif // HWY_HAVE_FLOAT64
 }
 
+// The incremental refill and the cache growth must not change the sequence.
+void TestCachedXorshiroSlices() {
+  const std::uint64_t seed = GetSeed();
+  constexpr std::size_t draws = 5 * 8192;
+  VectorXoshiro reference{seed};
+  const auto expected = reference(u64, draws);
+  const std::size_t configs[][2] = {
+      {256, 0}, {256, 64}, {1024, 32}, {4096, 0}, {4096, 64}, {8192, 256}};
+  for (const auto &config : configs) {
+    CachedXoshiro<> generator{seed, 0, config[0], config[1]};
+    for (std::size_t i = 0; i < draws; ++i) {
+      const std::uint64_t got = generator();
+      if (got != expected[i]) {
+        std::cerr << "SEED: " << seed << std::endl;
+        std::cerr << "TEST CachedXoshiro SLICE ERROR: capacity " << config[0]
+                  << " slice " << config[1] << " word " << i << " -> " << got
+                  << " != " << expected[i] << std::endl;
+        HWY_ASSERT(0);
+      }
+    }
+    HWY_ASSERT_EQ(generator.Size(), config[0]);
+  }
+}
+
+void TestUniformCachedXorshiroF32() {
+  // One cached 64-bit word yields two binary32 uniforms, low half first.
+  const std::uint64_t seed = GetSeed();
+  CachedXoshiro<> generator{seed};
+  CachedXoshiro<> reference{seed};
+  for (std::size_t i = 0UL; i < tests; i += 2) {
+    const std::uint64_t word = reference();
+    const auto lo = static_cast<std::uint32_t>(word);
+    const auto hi = static_cast<std::uint32_t>(word >> 32);
+    const float expected[2] = {internal::UniformFromBits<float>(lo),
+                               internal::UniformFromBits<float>(hi)};
+    for (const float result : expected) {
+      const float got = generator.Uniform(float{});
+      if (got != result || got < 0.F || got >= 1.F) {
+        std::cerr << "SEED: " << seed << std::endl;
+        std::cerr << "TEST CachedXoshiro UNIFORM F32 ERROR: " << got
+                  << " != " << result << std::endl;
+        HWY_ASSERT(0);
+      }
+    }
+  }
+}
+
+// A generator restored from a snapshot repeats the draws that followed the
+// snapshot; a truncated snapshot is rejected.
+template <class Generator, class Draw>
+void CheckSnapshot(const char *name, const std::uint64_t seed,
+                   Generator &generator, Generator &restored,
+                   const Draw &draw) {
+  for (std::size_t i = 0; i < 5 * tests + 3; ++i) {
+    draw(generator);
+  }
+  std::vector<std::uint8_t> snapshot;
+  internal::StateWriter writer{snapshot};
+  generator.SaveState(writer);
+  std::vector<std::uint64_t> expected(tests);
+  for (auto &value : expected) {
+    value = draw(generator);
+  }
+
+  internal::StateReader truncated{snapshot.data(), snapshot.size() - 1};
+  HWY_ASSERT(!restored.RestoreState(truncated));
+  internal::StateReader reader{snapshot.data(), snapshot.size()};
+  HWY_ASSERT(restored.RestoreState(reader));
+  HWY_ASSERT(reader.Done());
+  for (std::size_t i = 0; i < tests; ++i) {
+    const std::uint64_t got = draw(restored);
+    if (got != expected[i]) {
+      std::cerr << "SEED: " << seed << std::endl;
+      std::cerr << "TEST " << name << " SNAPSHOT ERROR: draw " << i << " -> "
+                << got << " != " << expected[i] << std::endl;
+      HWY_ASSERT(0);
+    }
+  }
+}
+
+void TestStateSnapshot() {
+  const std::uint64_t seed = GetSeed();
+  const ScalableTag<std::uint64_t> d;
+  const auto draw_vector = [d](auto &generator) {
+    return ReduceSum(d, generator(u64));
+  };
+
+  VectorXoshiro xoshiro{seed, 1};
+  VectorXoshiro xoshiro_restored{seed + 1};
+  CheckSnapshot("VectorXoshiro", seed, xoshiro, xoshiro_restored,
+                draw_vector);
+
+  VectorPhilox philox{seed, 1};
+  VectorPhilox philox_restored{seed + 1};
+  CheckSnapshot("VectorPhilox", seed, philox, philox_restored, draw_vector);
+
+#if HWY_TARGET != HWY_SCALAR
+  VectorAES aes{seed, 1};
+  VectorAES aes_restored{seed + 1};
+  CheckSnapshot("VectorAES", seed, aes, aes_restored, draw_vector);
+#endif
+
+  // The restored cache takes the capacity and the slice of the snapshot, and
+  // the pending half word of Uniform(float).
+  CachedXoshiro<> cached{seed, 1, 4096, 32};
+  CachedXoshiro<> cached_restored{seed + 1};
+  CheckSnapshot("CachedXoshiro", seed, cached, cached_restored,
+                [](CachedXoshiro<> &generator) {
+                  const float f = generator.Uniform(float{});
+                  return generator() ^ BitCastScalar<std::uint32_t>(f);
+                });
+  HWY_ASSERT_EQ(cached_restored.Capacity(), std::size_t{4096});
+}
+
+void TestUniformFromBits() {
+  // Bounds and resolution of the exponent-OR conversion.
+  HWY_ASSERT_EQ(internal::UniformFromBits<float>(std::uint32_t{0}), 0.F);
+  HWY_ASSERT_EQ(internal::UniformFromBits<float>(~std::uint32_t{0}),
+                1.F - 0x1.0p-23F);
+  HWY_ASSERT_EQ(internal::UniformFromBits<float>(std::uint32_t{1} << 9),
+                0x1.0p-23F);
+  HWY_ASSERT_EQ(internal::UniformFromBits<double>(std::uint64_t{0}), 0.0);
+  HWY_ASSERT_EQ(internal::UniformFromBits<double>(~std::uint64_t{0}),
+                1.0 - 0x1.0p-52);
+  HWY_ASSERT_EQ(internal::UniformFromBits<double>(std::uint64_t{1} << 12),
+                0x1.0p-52);
+
+  // The vector conversion matches the scalar one lane by lane.
+  const ScalableTag<float> df;
+  const ScalableTag<std::uint32_t> du;
+  const std::size_t lanes = Lanes(du);
+  VectorXoshiro generator{GetSeed()};
+  auto bits = hwy::MakeUniqueAlignedArray<std::uint32_t>(lanes);
+  auto uniform = hwy::MakeUniqueAlignedArray<float>(lanes);
+  for (std::size_t i = 0UL; i < tests; i += lanes) {
+    const auto v = generator(std::uint32_t{});
+    Store(v, du, bits.get());
+    Store(internal::UniformFromBits(df, v), df, uniform.get());
+    for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+      HWY_ASSERT_EQ(uniform[lane],
+                    internal::UniformFromBits<float>(bits[lane]));
+    }
+  }
+}
+
+void TestJumpTable() {
+  const auto &table = internal::GetJumpTable();
+  for (std::size_t j = 0UL; j < 4; ++j) {
+    if (table[0][j] != internal::kJump[j] or
+        table[64][j] != internal::kLongJump[j]) {
+      std::cerr << "TEST JUMP TABLE ERROR: word " << j << "\n";
+      HWY_ASSERT(0);
+    }
+  }
+}
+
+void TestJumpAhead() {
+  const std::uint64_t seed = GetSeed();
+  constexpr std::uint64_t max_jumps = 70;
+  internal::Xoshiro jump_reference{seed};
+  internal::Xoshiro long_jump_reference{seed};
+  for (std::uint64_t n = 0; n < max_jumps; ++n) {
+    internal::Xoshiro jump{seed};
+    internal::Xoshiro long_jump{seed};
+    jump.Jump(n);
+    long_jump.LongJump(n);
+    if (jump.GetState() != jump_reference.GetState() or
+        long_jump.GetState() != long_jump_reference.GetState()) {
+      std::cerr << "SEED: " << seed << "\n";
+      std::cerr << "TEST JUMP AHEAD ERROR: n = " << n << "\n";
+      HWY_ASSERT(0);
+    }
+    jump_reference.Jump();
+    long_jump_reference.LongJump();
+  }
+
+  // Jumps compose: Jump(a) then Jump(b) is Jump(a + b).
+  const std::uint64_t a = std::random_device()();
+  const std::uint64_t b = std::random_device()();
+  internal::Xoshiro composed{seed};
+  internal::Xoshiro direct{seed};
+  composed.LongJump(a);
+  composed.LongJump(b);
+  direct.LongJump(a + b);
+  if (composed.GetState() != direct.GetState()) {
+    std::cerr << "SEED: " << seed << "\n";
+    std::cerr << "TEST JUMP AHEAD ERROR: LongJump(" << a << ") + LongJump("
+              << b << ") != LongJump(" << a + b << ")\n";
+    HWY_ASSERT(0);
+  }
+}
+
+// Known-answer tests from the Random123 distribution (philox4x32_10).
+void TestPhiloxKnownAnswer() {
+  struct KAT {
+    std::uint32_t counter[4];
+    std::uint32_t key[2];
+    std::uint32_t expected[4];
+  };
+  const KAT kats[] = {
+      {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+      {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+       {0xffffffff, 0xffffffff},
+       {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+      {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+       {0xa4093822, 0x299f31d0},
+       {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+  };
+  const ScalableTag<std::uint64_t> d;
+  auto lo = Zero(d);
+  auto hi = Zero(d);
+  for (const auto &kat : kats) {
+    const std::uint64_t counter =
+        kat.counter[0] | (std::uint64_t{kat.counter[1]} << 32);
+    const std::uint64_t stream =
+        kat.counter[2] | (std::uint64_t{kat.counter[3]} << 32);
+    const std::uint64_t key = kat.key[0] | (std::uint64_t{kat.key[1]} << 32);
+    VectorPhilox::Block(key, stream, counter, lo, hi);
+    const std::uint64_t w01 = GetLane(lo);
+    const std::uint64_t w23 = GetLane(hi);
+    const std::uint32_t got[4] = {
+        static_cast<std::uint32_t>(w01), static_cast<std::uint32_t>(w01 >> 32),
+        static_cast<std::uint32_t>(w23), static_cast<std::uint32_t>(w23 >> 32)};
+    for (std::size_t i = 0; i < 4; ++i) {
+      if (got[i] != kat.expected[i]) {
+        std::cerr << "TEST PHILOX KAT ERROR: word " << i << " -> " << std::hex
+                  << got[i] << " != " << kat.expected[i] << std::dec << "\n";
+        HWY_ASSERT(0);
+      }
+    }
+  }
+}
+
+// The sequential interface must walk the counter space: call 2k returns the
+// low half of the blocks at counter k * lanes, call 2k + 1 their high half.
+void TestPhiloxSequence() {
+  const std::uint64_t seed = GetSeed();
+  const std::uint64_t stream = std::random_device()();
+  VectorPhilox generator{seed, stream};
+  const ScalableTag<std::uint64_t> d;
+  const std::size_t lanes = Lanes(d);
+  const auto result = generator(u64, tests);
+  const auto expected = hwy::MakeUniqueAlignedArray<std::uint64_t>(tests);
+  auto lo = Zero(d);
+  auto hi = Zero(d);
+  for (std::size_t i = 0, counter = 0; i < tests; i += 2 * lanes) {
+    VectorPhilox::Block(seed, stream, counter, lo, hi);
+    Store(lo, d, expected.get() + i);
+    Store(hi, d, expected.get() + i + lanes);
+    counter += lanes;
+  }
+  for (std::size_t i = 0; i < tests; ++i) {
+    if (result[i] != expected[i]) {
+      std::cerr << "SEED: " << seed << "\n";
+      std::cerr << "TEST PHILOX SEQUENCE ERROR: result[" << i << "] -> "
+                << result[i] << " != " << expected[i] << "\n";
+      HWY_ASSERT(0);
+    }
+  }
+}
+
+void TestPhiloxStreams() {
+  const std::uint64_t seed = GetSeed();
+  VectorPhilox generator0{seed, 0};
+  VectorPhilox generator1{seed, 1};
+  const auto result0 = generator0(u64, tests);
+  const auto result1 = generator1(u64, tests);
+  std::size_t equal = 0;
+  for (std::size_t i = 0; i < tests; ++i) {
+    equal += result0[i] == result1[i];
+  }
+  if (equal != 0) {
+    std::cerr << "SEED: " << seed << "\n";
+    std::cerr << "TEST PHILOX STREAMS ERROR: " << equal
+              << " equal values between streams 0 and 1\n";
+    HWY_ASSERT(0);
+  }
+}
+
+void TestPhiloxUniform() {
+#if HWY_HAVE_FLOAT64
+  const std::uint64_t seed = GetSeed();
+  VectorPhilox generator{seed};
+  const ScalableTag<double> d;
+  const std::size_t lanes = Lanes(d);
+  const auto result = hwy::MakeUniqueAlignedArray<double>(tests);
+  double sum = 0.0;
+  for (std::size_t i = 0; i < tests; i += lanes) {
+    Store(generator.Uniform(double{}), d, result.get() + i);
+  }
+  for (std::size_t i = 0; i < tests; ++i) {
+    if (0.0 > result[i] or 1.0 <= result[i]) {
+      std::cerr << "SEED: " << seed << "\n";
+      std::cerr << "TEST PHILOX UNIFORM ERROR: result[" << i << "] -> "
+                << result[i] << " out of bounds\n";
+      HWY_ASSERT(0);
+    }
+    sum += result[i];
+  }
+  // Mean of 1024 uniforms: 0.5 +/- 0.009 (1 sigma).
+  const double mean = sum / tests;
+  if (std::abs(mean - 0.5) > 0.05) {
+    std::cerr << "SEED: " << seed << "\n";
+    std::cerr << "TEST PHILOX UNIFORM ERROR: mean " << mean << "\n";
+    HWY_ASSERT(0);
+  }
+#endif // HWY_HAVE_FLOAT64
+}
+
+#if HWY_TARGET != HWY_SCALAR
+// The sequential interface walks the counter one 128-bit block per two lanes.
+void TestAESSequence() {
+  const std::uint64_t seed = GetSeed();
+  const std::uint64_t stream = std::random_device()();
+  VectorAES generator{seed, stream};
+  const ScalableTag<std::uint64_t> d;
+  const std::size_t lanes = Lanes(d);
+  auto got = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  auto expected = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  for (std::uint64_t counter = 0; counter < tests; counter += lanes / 2) {
+    Store(generator(u64), d, got.get());
+    Store(VectorAES::Block(seed, stream, counter), d, expected.get());
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      if (got[lane] != expected[lane]) {
+        std::cerr << "SEED: " << seed << "\n";
+        std::cerr << "TEST AES SEQUENCE ERROR: counter " << counter
+                  << " lane " << lane << " -> " << got[lane]
+                  << " != " << expected[lane] << "\n";
+        HWY_ASSERT(0);
+      }
+    }
+  }
+  HWY_ASSERT_EQ(generator.GetCounter(), tests);
+
+  // Block i of a vector is the block of counter + i.
+  const std::uint64_t counter = std::random_device()();
+  Store(VectorAES::Block(seed, stream, counter), d, got.get());
+  for (std::size_t block = 0; block < lanes / 2; ++block) {
+    Store(VectorAES::Block(seed, stream, counter + block), d, expected.get());
+    HWY_ASSERT_EQ(got[2 * block], expected[0]);
+    HWY_ASSERT_EQ(got[2 * block + 1], expected[1]);
+  }
+}
+
+void TestAESStreams() {
+  const std::uint64_t seed = GetSeed();
+  const ScalableTag<std::uint64_t> d;
+  const auto a = VectorAES::Block(seed, 0, 0);
+  const auto b = VectorAES::Block(seed, 1, 0);
+  const auto c = VectorAES::Block(seed + 1, 0, 0);
+  if (!AllFalse(d, Eq(a, b)) or !AllFalse(d, Eq(a, c))) {
+    std::cerr << "SEED: " << seed << "\n";
+    std::cerr << "TEST AES STREAMS ERROR: identical words across streams\n";
+    HWY_ASSERT(0);
+  }
+}
+
+// Each of the 64 bit positions is set with probability 1/2.
+void TestAESBitFrequency() {
+  constexpr std::size_t words = 1UL << 16;
+  const std::uint64_t seed = GetSeed();
+  VectorAES generator{seed};
+  const auto result = generator(u64, words);
+  std::size_t ones[64] = {};
+  for (std::size_t i = 0; i < words; ++i) {
+    for (std::size_t bit = 0; bit < 64; ++bit) {
+      ones[bit] += (result[i] >> bit) & 1;
+    }
+  }
+  // 6 sigma of a binomial(words, 1/2).
+  const double bound = 6 * std::sqrt(words / 4.0);
+  for (std::size_t bit = 0; bit < 64; ++bit) {
+    const double deviation = std::abs(ones[bit] - words / 2.0);
+    if (deviation > bound) {
+      std::cerr << "SEED: " << seed << "\n";
+      std::cerr << "TEST AES BIT FREQUENCY ERROR: bit " << bit << " set "
+                << ones[bit] << " times out of " << words << "\n";
+      HWY_ASSERT(0);
+    }
+  }
+}
+
+template <typename T> void CheckAESUniform(const std::uint64_t seed) {
+  VectorAES generator{seed};
+  const ScalableTag<T> d;
+  const std::size_t lanes = Lanes(d);
+  const auto result = hwy::MakeUniqueAlignedArray<T>(tests);
+  double sum = 0.0;
+  for (std::size_t i = 0; i < tests; i += lanes) {
+    Store(generator.Uniform(T{}), d, result.get() + i);
+  }
+  for (std::size_t i = 0; i < tests; ++i) {
+    if (T{0} > result[i] or T{1} <= result[i]) {
+      std::cerr << "SEED: " << seed << "\n";
+      std::cerr << "TEST AES UNIFORM ERROR: result[" << i << "] -> "
+                << result[i] << " out of bounds\n";
+      HWY_ASSERT(0);
+    }
+    sum += result[i];
+  }
+  // Mean of 1024 uniforms: 0.5 +/- 0.009 (1 sigma).
+  const double mean = sum / tests;
+  if (std::abs(mean - 0.5) > 0.05) {
+    std::cerr << "SEED: " << seed << "\n";
+    std::cerr << "TEST AES UNIFORM ERROR: mean " << mean << "\n";
+    HWY_ASSERT(0);
+  }
+}
+
+void TestAESUniform() {
+  const std::uint64_t seed = GetSeed();
+  CheckAESUniform<float>(seed);
+#if HWY_HAVE_FLOAT64
+  CheckAESUniform<double>(seed);
+
+  CachedXoshiro<kCachedXoshiroSize, VectorAES> cached{seed};
+  std::uniform_real_distribution<double> distribution{0., 1.};
+  for (std::size_t i = 0UL; i < tests; ++i) {
+    const double result = distribution(cached);
+    if (result < 0. || result >= 1.) {
+      std::cerr << "SEED: " << seed << std::endl;
+      std::cerr << "TEST CachedXoshiro<VectorAES> ERROR: result_array[" << i
+                << "] -> " << result << " not in interval [0, 1)" << std::endl;
+      HWY_ASSERT(0);
+    }
+  }
+#endif // HWY_HAVE_FLOAT64
+}
+#else
+void TestAESSequence() {}
+void TestAESStreams() {}
+void TestAESBitFrequency() {}
+void TestAESUniform() {}
+#endif // HWY_TARGET != HWY_SCALAR
+
 } // namespace
 // NOLINTNEXTLINE(google-readability-namespace-comments)
 } // namespace HWY_NAMESPACE
@@ -479,6 +915,20 @@ HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestNextNUniformVecDistF32);
 HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestNextFixedNUniformDist);
 HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestNextFixedNUniformVecDistF32);
 HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestUniformCachedXorshiro);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestCachedXorshiroSlices);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestUniformCachedXorshiroF32);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestStateSnapshot);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestUniformFromBits);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestJumpTable);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestJumpAhead);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestPhiloxKnownAnswer);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestPhiloxSequence);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestPhiloxStreams);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestPhiloxUniform);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestAESSequence);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestAESStreams);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestAESBitFrequency);
+HWY_EXPORT_AND_TEST_P(HwyRandomTest, TestAESUniform);
 HWY_AFTER_TEST();
 // NOLINTEND
 } // namespace
@@ -11,6 +11,7 @@
 #include <ctime>
 #include <iostream> // cerr
 #include <random>
+#include <thread>
 #include <vector>
 
 // clang-format off
@@ -517,6 +518,289 @@ void TestUniformCachedXorshiro() {
 #endif // HWY_HAVE_FLOAT64
 }
 
+void TestUniformRingRefill() {
+#if HWY_HAVE_FLOAT64
+  // Go through several refills of the ring to check that the bulk refill
+  // yields the same sequence as the on-demand generation.
+  constexpr std::uint64_t tests_ring = 4 * kUniformRingSize + tests;
+  const std::uint64_t seed = GetSeed();
+  const auto result_array = hwy::MakeUniqueAlignedArray<double>(tests_ring);
+  UniformLoopVector(seed, result_array.get(), tests_ring);
+  VectorXoshiro reference{seed};
+  const ScalableTag<double> d;
+  const std::size_t lanes = Lanes(d);
+  auto expected = hwy::MakeUniqueAlignedArray<double>(lanes);
+  for (std::size_t i = 0UL; i < tests_ring; i += lanes) {
+    Store(reference.Uniform(double{}), d, expected.get());
+    for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+      if (result_array[i + lane] != expected[lane]) {
+        std::cerr << "SEED: " << seed << std::endl;
+        std::cerr << "TEST UNIFORM RING ERROR: result_array[" << i + lane
+                  << "] -> " << result_array[i + lane]
+                  << " != " << expected[lane] << std::endl;
+        HWY_ASSERT(0);
+      }
+    }
+  }
+
+  // Reseeding must drop the values left in the ring.
+  UniformLoopVector(seed, result_array.get(), lanes);
+  InitRngVector(seed);
+  const auto first = rng_vector::uniform(double{});
+  if (GetLane(first) != result_array[0]) {
+    std::cerr << "SEED: " << seed << std::endl;
+    std::cerr << "TEST UNIFORM RING ERROR: ring not reset on reseed"
+              << std::endl;
+    HWY_ASSERT(0);
+  }
+#endif // HWY_HAVE_FLOAT64
+}
+
+template <typename T> void CheckRandomBitPlanes(const std::uint64_t seed) {
+  // randombit() hands out the words of the generator one bit-plane at a time,
+  // most significant bit first: kWidth calls rebuild one random vector.
+  constexpr std::size_t kWidth = sizeof(T) * 8;
+  const ScalableTag<T> d;
+  const std::size_t lanes = Lanes(d);
+  InitRngVector(seed);
+  VectorXoshiro reference{seed};
+  auto expected = hwy::MakeUniqueAlignedArray<T>(lanes);
+  auto bit = hwy::MakeUniqueAlignedArray<T>(lanes);
+  for (std::size_t i = 0UL; i < tests; i += lanes) {
+    Store(reference(T{}), d, expected.get());
+    std::vector<T> words(lanes, 0);
+    for (std::size_t plane = 0UL; plane < kWidth; ++plane) {
+      Store(rng_vector::randombit(T{}), d, bit.get());
+      for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+        HWY_ASSERT(bit[lane] <= 1);
+        words[lane] = static_cast<T>((words[lane] << 1) | bit[lane]);
+      }
+    }
+    for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+      if (words[lane] != expected[lane]) {
+        std::cerr << "SEED: " << seed << std::endl;
+        std::cerr << "TEST RANDOMBIT ERROR: word[" << i + lane << "] -> "
+                  << words[lane] << " != " << expected[lane] << std::endl;
+        HWY_ASSERT(0);
+      }
+    }
+  }
+}
+
+void TestRandomBitPlanes() {
+  const std::uint64_t seed = GetSeed();
+  CheckRandomBitPlanes<std::uint32_t>(seed);
+  CheckRandomBitPlanes<std::uint64_t>(seed);
+
+  // The scalar pool uses every bit of a 64-bit word as well.
+  rng_scalar::internal::init_rng(seed, 0);
+  std::uint64_t word = 0;
+  for (std::size_t i = 0UL; i < UINT64_WIDTH; ++i) {
+    word = (word << 1) | rng_scalar::randombit(u64);
+  }
+  rng_scalar::internal::init_rng(seed, 0);
+  if (word != rng_scalar::random()) {
+    std::cerr << "SEED: " << seed << std::endl;
+    std::cerr << "TEST RANDOMBIT ERROR: scalar bits do not rebuild the word"
+              << std::endl;
+    HWY_ASSERT(0);
+  }
+}
+
+void TestStatePoolRecycling() {
+  // A seed no other test uses, so that only the states released here match.
+  const std::uint64_t seed = GetSeed() ^ std::random_device()();
+  set_user_seed(seed);
+  const ScalableTag<std::uint64_t> d;
+  const std::size_t lanes = Lanes(d);
+
+  // First thread: fresh state on its own stream, released at exit.
+  std::uint64_t tid = 0;
+  auto first = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  std::thread([&] {
+    tid = get_thread_id();
+    Store(rng_vector::random(u64), d, first.get());
+  }).join();
+
+  // Second thread: adopts the released state and resumes its stream.
+  const std::uint64_t hits = prism::state_pool::hits.load();
+  auto second = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  std::thread([&] {
+    Store(rng_vector::random(u64), d, second.get());
+  }).join();
+  HWY_ASSERT_EQ(prism::state_pool::hits.load(), hits + 1);
+
+  rng_vector::internal::RNG reference{seed, tid};
+  auto expected = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  Store(reference(u64), d, expected.get());
+  for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+    HWY_ASSERT_EQ(first[lane], expected[lane]);
+  }
+  Store(reference(u64), d, expected.get());
+  for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+    if (second[lane] != expected[lane]) {
+      std::cerr << "SEED: " << seed << std::endl;
+      std::cerr << "TEST STATE POOL ERROR: adopted stream lane " << lane
+                << " -> " << second[lane] << " != " << expected[lane]
+                << std::endl;
+      HWY_ASSERT(0);
+    }
+  }
+
+  // A state created under another seed is never adopted.
+  set_user_seed(seed + 1);
+  const std::uint64_t misses = prism::state_pool::misses.load();
+  std::thread([&] { rng_vector::random(u64); }).join();
+  HWY_ASSERT_EQ(prism::state_pool::misses.load(), misses + 1);
+}
+
+// A thread bound to a stream frees its state at exit: a thread binding to the
+// same stream later restarts it, so an adopter would draw the same words.
+void TestStatePoolSkipsBoundThreads() {
+  set_user_seed(GetSeed() ^ std::random_device()());
+  const std::uint64_t hits = prism::state_pool::hits.load();
+  std::thread([] {
+    prism::rng_stream::bind(7);
+    rng_vector::random(u64);
+  }).join();
+  const std::uint64_t misses = prism::state_pool::misses.load();
+  std::thread([] { rng_vector::random(u64); }).join();
+  HWY_ASSERT_EQ(prism::state_pool::misses.load(), misses + 1);
+  HWY_ASSERT_EQ(prism::state_pool::hits.load(), hits);
+}
+
+// The scalar and the vector API of a thread share one generator: vector draws
+// take the engine output directly and the scalar cache is filled from the
+// words that follow, on its first draw.
+void TestSharedGenerator() {
+  const std::uint64_t seed = GetSeed();
+  const ScalableTag<std::uint64_t> d;
+  const std::size_t lanes = Lanes(d);
+  InitRngVector(seed);
+  HWY_ASSERT(&rng_scalar::internal::get_rng()->Engine() ==
+             rng_vector::internal::get_rng());
+
+  rng_vector::internal::RNG reference{seed, 0};
+  auto got = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  auto expected = hwy::MakeUniqueAlignedArray<std::uint64_t>(lanes);
+  Store(rng_vector::random(u64), d, got.get());
+  Store(reference(u64), d, expected.get());
+  for (std::size_t lane = 0UL; lane < lanes; ++lane) {
+    HWY_ASSERT_EQ(got[lane], expected[lane]);
+  }
+
+  const auto words = AllocateAligned<std::uint64_t>(kCachedXoshiroInitialSize);
+  reference.fill(words.get(), kCachedXoshiroInitialSize);
+  for (std::size_t i = 0UL; i < kCachedXoshiroInitialSize; ++i) {
+    if (rng_scalar::random() != words[i]) {
+      std::cerr << "SEED: " << seed << std::endl;
+      std::cerr << "TEST SHARED GENERATOR ERROR: scalar word " << i
+                << " is not the engine output" << std::endl;
+      HWY_ASSERT(0);
+    }
+  }
+
+  // A thread using both APIs takes a single state.
+  const std::uint64_t acquired =
+      prism::state_pool::hits.load() + prism::state_pool::misses.load();
+  std::thread([] {
+    rng_scalar::random();
+    rng_vector::random(u64);
+  }).join();
+  HWY_ASSERT_EQ(
+      prism::state_pool::hits.load() + prism::state_pool::misses.load(),
+      acquired + 1);
+}
+
+// Fills a buffer of n values one element past an aligned address, between two
+// sentinels, and checks it against the per-vector draws of a reference
+// generator.
+template <typename T, class Fill, class Draw>
+void CheckFill(const char *name, const std::uint64_t seed, const Fill &fill,
+               const Draw &draw) {
+  const ScalableTag<T> d;
+  const std::size_t lanes = Lanes(d);
+  constexpr T kSentinel = T{42};
+  for (const std::size_t n : {std::size_t{0}, std::size_t{1}, lanes - 1,
+                              lanes, lanes + 1, std::size_t{1003}}) {
+    auto buffer = hwy::AllocateAligned<T>(n + 2);
+    buffer[0] = kSentinel;
+    buffer[n + 1] = kSentinel;
+    InitRngVector(seed);
+    fill(buffer.get() + 1, n);
+    HWY_ASSERT_EQ(buffer[0], kSentinel);
+    HWY_ASSERT_EQ(buffer[n + 1], kSentinel);
+
+    rng_vector::internal::RNG reference{seed, 0};
+    auto expected = hwy::AllocateAligned<T>(lanes);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i % lanes == 0) {
+        Store(draw(reference), d, expected.get());
+      }
+      if (buffer[i + 1] != expected[i % lanes]) {
+        std::cerr << "SEED: " << seed << std::endl;
+        std::cerr << "TEST FILL ERROR: " << name << " n = " << n << ", value "
+                  << i << std::endl;
+        HWY_ASSERT(0);
+      }
+    }
+  }
+}
+
+void TestFillAPI() {
+  const std::uint64_t seed = GetSeed();
+  using Engine = rng_vector::internal::RNG;
+  CheckFill<std::uint64_t>(
+      "fill(u64)", seed,
+      [](std::uint64_t *data, std::size_t n) { rng_vector::fill(data, n); },
+      [](Engine &engine) { return engine(u64); });
+  CheckFill<std::uint32_t>(
+      "fill(u32)", seed,
+      [](std::uint32_t *data, std::size_t n) { rng_vector::fill(data, n); },
+      [](Engine &engine) { return engine(std::uint32_t{}); });
+  CheckFill<float>(
+      "fill_uniform(float)", seed,
+      [](float *data, std::size_t n) { rng_vector::fill_uniform(data, n); },
+      [](Engine &engine) { return engine.Uniform(float{}); });
+#if HWY_HAVE_FLOAT64
+  CheckFill<double>(
+      "fill_uniform(double)", seed,
+      [](double *data, std::size_t n) { rng_vector::fill_uniform(data, n); },
+      [](Engine &engine) { return engine.Uniform(double{}); });
+#endif
+  // The dynamic dispatch entry point draws from the same per-thread stream.
+  CheckFill<std::uint64_t>(
+      "rng_fill::fill(u64)", seed,
+      [](std::uint64_t *data, std::size_t n) {
+        prism::rng_fill::fill(data, n);
+      },
+      [](Engine &engine) { return engine(u64); });
+}
+
+void TestCacheGrowth() {
+  const std::uint64_t seed = GetSeed();
+  using Cached = rng_scalar::internal::RNG;
+  Cached small{seed, 0, 256};
+  Cached large{seed, 0, 4096};
+  HWY_ASSERT_EQ(large.Size(), kCachedXoshiroInitialSize);
+  // Same words whatever the capacity; the cache doubles until full.
+  for (std::size_t i = 0UL; i < 4 * 4096; ++i) {
+    HWY_ASSERT_EQ(small(), large());
+  }
+  HWY_ASSERT_EQ(small.Size(), std::size_t{256});
+  HWY_ASSERT_EQ(large.Size(), std::size_t{4096});
+  HWY_ASSERT_EQ(large.Capacity(), std::size_t{4096});
+
+  // Invalid capacities are ignored, release builds included.
+  const std::uint64_t size = prism::rng_cache::get_cache_size();
+  for (const std::uint64_t words :
+       {UINT64_C(0), UINT64_C(100), UINT64_C(128), UINT64_C(3000),
+        UINT64_C(1) << 21}) {
+    prism::rng_cache::set_cache_size(words);
+    HWY_ASSERT_EQ(prism::rng_cache::get_cache_size(), size);
+  }
+}
+
 } // namespace
 // NOLINTNEXTLINE(google-readability-namespace-comments)
 } // namespace hwy::HWY_NAMESPACE
@@ -542,6 +826,13 @@ HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestNextFixedNUniformDist);
 HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestNextFixedNUniformVecDistF32);
 HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestCachedXorshiro);
 HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestUniformCachedXorshiro);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestUniformRingRefill);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestRandomBitPlanes);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestStatePoolRecycling);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestStatePoolSkipsBoundThreads);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestSharedGenerator);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestFillAPI);
+HWY_EXPORT_AND_TEST_P(PRISMXoshiroAPITest, TestCacheGrowth);
 // NOLINTEND
 HWY_AFTER_TEST();
 } // namespace